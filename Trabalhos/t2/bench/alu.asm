@@ -0,0 +1,19 @@
+; bench/alu.asm
+; carga de trabalho de CPU pura: laço infinito de operações aritméticas
+; não faz chamadas de sistema; os únicos acessos a dados na memória são
+;   às constantes (não tem instrução aritmética com imediato)
+
+         cargi 0
+         trax
+laco     incx
+         cpxa
+         mult tres
+         soma sete
+         resto primo
+         neg
+         desvn laco
+         desv laco
+
+tres     valor 3
+sete     valor 7
+primo    valor 997
@@ -0,0 +1,38 @@
+; bench/escrita.asm
+; carga de trabalho com muitas chamadas de sistema: imprime uma linha
+;   indefinidamente, uma chamada de sistema por caractere
+
+SO_ESCR        define 2
+
+nl       define 10
+
+laco     cargi msg
+         chama impstr
+         cargi nl
+         chama impch
+         desv laco
+
+msg      string 'bench de escrita, uma chamada de sistema por caractere'
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+impstr1
+         cargx 0
+         desvz impstrf
+         chama impch
+         incx
+         desv impstr1
+impstrf  ret impstr
+
+; chama o SO para imprimir o caractere em A
+; não altera o valor de X
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
@@ -0,0 +1,18 @@
+; bench/filho.asm
+; processo filho de bench/processos.asm: conta um pouco e morre
+
+SO_MATA_PROC   define 8
+N              define 100
+
+         cargi 0
+         trax
+laco     incx
+         cpxa
+         sub n
+         desvnz laco
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+n        valor N
@@ -0,0 +1,22 @@
+; bench/memoria.asm
+; carga de trabalho de acesso sequencial à memória: percorre um vetor
+;   grande, copiando cada posição (mais 1) para outro vetor, com acesso
+;   indexado (CARGX e ARMX), indefinidamente
+
+TAM      define 3000
+
+inicio   cargi 0
+         trax
+copia    cargx orig
+         soma um
+         armx dest
+         incx
+         cpxa
+         sub tam
+         desvnz copia
+         desv inicio
+
+um       valor 1
+tam      valor TAM
+orig     espaco TAM
+dest     espaco TAM
@@ -0,0 +1,28 @@
+; bench/paginas.asm
+; carga de trabalho que espalha os acessos por muitas páginas: percorre um
+;   vetor grande com passo maior que o tamanho da página, alterando uma
+;   posição em cada acesso, indefinidamente
+; cada acesso cai numa página diferente da anterior, o que faz a TLB (e,
+;   com memória virtual, a memória principal) não ter onde se apoiar
+
+TAM      define 5000
+PASSO    define 37
+
+inicio   cargi 0
+         trax
+laco     cargx vetor
+         soma um
+         armx vetor
+         ; X += PASSO (trax deixa em A o X antigo)
+         cpxa
+         soma passo
+         trax
+         cpxa
+         sub tam
+         desvn laco
+         desv inicio
+
+um       valor 1
+passo    valor PASSO
+tam      valor TAM
+vetor    espaco TAM
@@ -0,0 +1,19 @@
+; bench/processos.asm
+; carga de trabalho de criação de processos: cria um processo filho
+;   (bench/filho.maq), espera ele morrer, e repete indefinidamente
+; se a criação falhar, tenta de novo
+
+SO_CRIA_PROC   define 7
+SO_ESPERA_PROC define 9
+
+laco     cargi filho
+         trax
+         cargi SO_CRIA_PROC
+         chamas
+         desvn laco
+         trax
+         cargi SO_ESPERA_PROC
+         chamas
+         desv laco
+
+filho    string 'bench/filho.maq'
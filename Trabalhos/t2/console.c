@@ -27,6 +27,15 @@
 #define LINHA_CONSOLE (LINHA_STATUS + N_LIN_STATUS)
 #define LINHA_ENTRADA (LINHA_CONSOLE + N_LIN_CONSOLE)
 
+// intervalo mínimo (em microssegundos de tempo real) entre duas consultas
+//   ao teclado -- consultar o curses é caro, e a console é chamada muitas
+//   vezes por segundo
+#define INTERVALO_TECLADO 10000
+
+// número padrão de vezes por segundo (tempo real) que a tela é redesenhada
+//   (ver console_define_quadros_por_segundo)
+#define QUADROS_POR_SEGUNDO 30
+
 // identificação da cor para cada parte
 #define COR_TXT_PAR      1
 #define COR_CURSOR_PAR   2
@@ -58,6 +67,8 @@ typedef struct {
   enum { normal, rolando, limpando } estado_saida;
   int cor_txt;
   int cor_cursor;
+  // o terminal mudou desde a última vez que foi desenhado
+  bool alterado;
 } term_t;
 
 struct console_t {
@@ -66,12 +77,28 @@ struct console_t {
   char txt_console[N_LIN_CONSOLE][N_COL+1];
   char digitando[N_COL+1];
   char fila_de_comandos_externos[N_CMD_EXT];
+  // momento (em us) da última consulta ao teclado
+  long long t_ult_teclado;
+  // partes da tela que mudaram desde a última vez que foram desenhadas
+  bool status_alterado;
+  bool console_alterada;
+  bool entrada_alterada;
+  // intervalo (em us) entre dois redesenhos da tela, e momento do último
+  long long intervalo_quadro;
+  long long t_ult_quadro;
+  // controlador de interrupções, e pedidos de interrupção ligados
+  pic_t *pic;
+  bool irq_teclado;
+  bool irq_tela;
 };
 
 // funções auxiliares
 static void init_curses(void);
+static long long agora_us(void);
+static void desenha_alteracoes(console_t *self);
+static void muda_irq(console_t *self, irq_t irq, bool ativa);
 
-console_t *console_cria(void)
+console_t *console_cria(pic_t *pic)
 {
   console_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
@@ -80,6 +107,7 @@ console_t *console_cria(void)
     self->term[t].entrada[0] = '\0';
     self->term[t].saida[0] = '\0';
     self->term[t].estado_saida = normal;
+    self->term[t].alterado = true;
     if (t%2 == 0) {
       self->term[t].cor_txt = COR_TXT_PAR;
       self->term[t].cor_cursor = COR_CURSOR_PAR;
@@ -93,6 +121,16 @@ console_t *console_cria(void)
   }
   self->digitando[0] = '\0';
   self->fila_de_comandos_externos[0] = '\0';
+  self->t_ult_teclado = 0;
+  self->txt_status[0] = '\0';
+  self->status_alterado = true;
+  self->console_alterada = true;
+  self->entrada_alterada = true;
+  console_define_quadros_por_segundo(self, QUADROS_POR_SEGUNDO);
+  self->t_ult_quadro = 0;
+  self->pic = pic;
+  self->irq_teclado = false;
+  self->irq_tela = false;
 
   init_curses();
 
@@ -106,7 +144,7 @@ static void init_curses(void)
   initscr();
   cbreak();      // lê cada char, não espera enter
   noecho();      // não mostra o que é digitado
-  timeout(5);    // não espera digitar, retorna ERR se nada foi digitado
+  timeout(0);    // não espera digitar, retorna ERR se nada foi digitado
   start_color();
   init_pair(COR_TXT_PAR, COLOR_GREEN, COLOR_BLACK);
   init_pair(COR_CURSOR_PAR, COLOR_BLACK, COLOR_GREEN);
@@ -119,9 +157,10 @@ static void init_curses(void)
 
 void console_destroi(console_t *self)
 {
-  console_atualiza(self);
+  desenha_alteracoes(self);
   attron(COLOR_PAIR(COR_OCUPADO));
   addstr("  digite ENTER para sair  ");
+  timeout(-1);   // agora pode esperar
   while (getch() != '\n') {
     ;
   }
@@ -132,6 +171,33 @@ void console_destroi(console_t *self)
   return;
 }
 
+bool console_interativa(console_t *self)
+{
+  return true;
+}
+
+void console_define_quadros_por_segundo(console_t *self, int qps)
+{
+  if (qps < 1) qps = 1;
+  self->intervalo_quadro = 1000000 / qps;
+}
+
+
+// INTERRUPÇÕES
+
+// liga ou desliga o pedido de interrupção do teclado ou da tela
+static void muda_irq(console_t *self, irq_t irq, bool ativa)
+{
+  if (irq == IRQ_TECLADO) {
+    self->irq_teclado = ativa;
+  } else {
+    self->irq_tela = ativa;
+  }
+  if (self->pic != NULL) {
+    pic_sinaliza(self->pic, irq, ativa);
+  }
+}
+
 
 // SAIDA
 
@@ -143,6 +209,7 @@ static bool pode_imprimir_no_term(console_t *self, int t)
 static void imprime_no_term(console_t *self, int t, char ch)
 {
   if (pode_imprimir_no_term(self, t)) {
+    self->term[t].alterado = true;
     if (ch == '\n') {
       self->term[t].estado_saida = limpando;
       return;
@@ -184,16 +251,23 @@ static void rola_saidas(console_t *self)
 {
   for (int t = 0; t < N_TERM; t++) {
     term_t *termp = &self->term[t];
+    int estado_ant = termp->estado_saida;
     switch (termp->estado_saida) {
       case normal: 
         break;
       case rolando:
         rola_saida(termp);
+        termp->alterado = true;
         break;
       case limpando:
         limpa_saida(termp);
+        termp->alterado = true;
         break;
     }
+    // o terminal voltou a aceitar escrita
+    if (termp->estado_saida == normal && estado_ant != normal) {
+      muda_irq(self, IRQ_TELA, true);
+    }
   }
 }
 
@@ -211,6 +285,7 @@ static char remove_char_do_term(console_t *self, int t)
   char *p = self->term[t].entrada;
   char ch = *p;
   memmove(p, p+1, strlen(p));
+  self->term[t].alterado = true;
   return ch;
 }
 
@@ -221,6 +296,11 @@ static void insere_char_no_term(console_t *self, int t, char ch)
   if (tam >= N_COL-2) return;
   p[tam] = ch;
   p[tam+1] = '\0';
+  self->term[t].alterado = true;
+  // o terminal passou a ter o que ler
+  if (tam == 0) {
+    muda_irq(self, IRQ_TECLADO, true);
+  }
 }
 
 
@@ -234,6 +314,7 @@ static void insere_string_na_console(console_t *self, char *s)
   }
   strncpy(self->txt_console[N_LIN_CONSOLE-1], s, N_COL);
   self->txt_console[N_LIN_CONSOLE-1][N_COL] = '\0'; // grrrr
+  self->console_alterada = true;
 }
 
 static void insere_strings_na_console(console_t *self, char *s)
@@ -252,7 +333,12 @@ static void insere_strings_na_console(console_t *self, char *s)
 void console_print_status(console_t *self, char *txt)
 {
   // imprime alinhado a esquerda ("-"), max N_COL chars ("*")
-  sprintf(self->txt_status, "%-*s", N_COL, txt);
+  char novo[N_COL+1];
+  snprintf(novo, sizeof(novo), "%-*s", N_COL, txt);
+  if (strcmp(novo, self->txt_status) != 0) {
+    strcpy(self->txt_status, novo);
+    self->status_alterado = true;
+  }
 }
 
 int console_printf(console_t *self, char *formato, ...)
@@ -300,8 +386,12 @@ static void limpa_saida_do_term(console_t *self, char c)
     console_printf(self, "Terminal '%c' inválido\n", c);
     return;
   }
+  if (self->term[t].estado_saida != normal) {
+    muda_irq(self, IRQ_TELA, true);
+  }
   self->term[t].saida[0] = '\0';
   self->term[t].estado_saida = normal;
+  self->term[t].alterado = true;
 }
 
 static void insere_comando_externo(console_t *self, char c)
@@ -355,14 +445,22 @@ static void interpreta_entrada(console_t *self)
       console_printf(self, "Comando '%c' não reconhecido", cmd);
   }
   self->digitando[0] = '\0';
+  self->entrada_alterada = true;
 }
 
-// lê e guarda um caractere do teclado; interpreta linha se for 'enter'
-static void verifica_entrada(console_t *self)
+// tempo real, em microssegundos
+static long long agora_us(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000LL + t.tv_nsec / 1000;
+}
+
+// trata um caractere digitado; interpreta linha se for 'enter'
+static void trata_caractere(console_t *self, int ch)
 {
-  int ch = getch();
-  if (ch == ERR) return;
   int l = strlen(self->digitando);
+  self->entrada_alterada = true;
   if (ch == '\b' || ch == 127) {   // backspace ou del
     if (l > 0) {
       self->digitando[l-1] = '\0';
@@ -375,6 +473,19 @@ static void verifica_entrada(console_t *self)
   } // senão, ignora o caractere digitado
 }
 
+// lê e trata os caracteres já digitados, sem esperar
+// só consulta o teclado se já passou INTERVALO_TECLADO desde a última vez
+static void verifica_entrada(console_t *self)
+{
+  long long agora = agora_us();
+  if (agora - self->t_ult_teclado < INTERVALO_TECLADO) return;
+  self->t_ult_teclado = agora;
+  int ch;
+  while ((ch = getch()) != ERR) {
+    trata_caractere(self, ch);
+  }
+}
+
 
 // DESENHO
 
@@ -400,6 +511,8 @@ static void desenha_terminais(console_t *self)
 {
   for (int t=0; t<N_TERM; t++) {
     term_t *termp = &self->term[t];
+    if (!termp->alterado) continue;
+    termp->alterado = false;
     int linha = LINHA_TERM + t*2;
     attron(COLOR_PAIR(termp->cor_txt));
     desenha_terminal(termp, linha);
@@ -409,6 +522,8 @@ static void desenha_terminais(console_t *self)
 
 static void desenha_status(console_t *self)
 {
+  if (!self->status_alterado) return;
+  self->status_alterado = false;
   attron(COLOR_PAIR(4));
   mvprintw(LINHA_STATUS, 0, "%-*s", N_COL, self->txt_status);
   attroff(COLOR_PAIR(4));
@@ -416,6 +531,8 @@ static void desenha_status(console_t *self)
 
 static void desenha_console(console_t *self)
 {
+  if (!self->console_alterada) return;
+  self->console_alterada = false;
   attron(COLOR_PAIR(COR_CONSOLE));
   for (int l=0; l<N_LIN_CONSOLE; l++) {
     int y = LINHA_CONSOLE + l;
@@ -426,6 +543,8 @@ static void desenha_console(console_t *self)
 
 static void desenha_entrada(console_t *self)
 {
+  if (!self->entrada_alterada) return;
+  self->entrada_alterada = false;
   attron(COLOR_PAIR(COR_ENTRADA));
   mvprintw(LINHA_ENTRADA, 0, "%*s", N_COL, 
            "P=para C=continua 1=passo F=fim  Ets=entra Zt=zera");
@@ -445,21 +564,55 @@ void console_tictac(console_t *self)
   rola_saidas(self);
 }
 
-void console_atualiza(console_t *self)
+// desenha as partes da tela que foram alteradas, se houver alguma
+static void desenha_alteracoes(console_t *self)
 {
+  bool alguma = self->status_alterado || self->console_alterada
+                || self->entrada_alterada;
+  for (int t=0; t<N_TERM; t++) {
+    alguma = alguma || self->term[t].alterado;
+  }
+  if (!alguma) return;
+
   desenha_terminais(self);
   desenha_status(self);
   desenha_console(self);
   desenha_entrada(self);
 
+  // o cursor fica onde foi o último desenho; tem que ficar depois do que
+  //   está sendo digitado mesmo se a linha de entrada não foi redesenhada
+  move(LINHA_ENTRADA, strlen(self->digitando));
   // manda o curses fazer aparecer tudo isso
   refresh();
 }
 
+bool console_hora_de_atualizar(console_t *self)
+{
+  return agora_us() - self->t_ult_quadro >= self->intervalo_quadro;
+}
+
+void console_atualiza(console_t *self)
+{
+  if (!console_hora_de_atualizar(self)) return;
+  self->t_ult_quadro = agora_us();
+  desenha_alteracoes(self);
+}
+
 
 err_t term_le(void *disp, int id, int *pvalor)
 {
   console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO) {
+    *pvalor = self->irq_teclado ? 1 : 0;
+    return ERR_OK;
+  } else if (id == CONSOLE_IRQ_TELA) {
+    *pvalor = self->irq_tela ? 1 : 0;
+    return ERR_OK;
+  } else if (id == CONSOLE_ENTRADA_ESGOTADA) {
+    // o operador sempre pode digitar mais
+    *pvalor = 0;
+    return ERR_OK;
+  }
   // cada terminal tem 4 dispositivos:
   //   leitura, estado da leitura, escrita, estado da escrita
   int term = id / 4;
@@ -494,6 +647,13 @@ err_t term_le(void *disp, int id, int *pvalor)
 err_t term_escr(void *disp, int id, int valor)
 {
   console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO) {
+    muda_irq(self, IRQ_TECLADO, valor != 0);
+    return ERR_OK;
+  } else if (id == CONSOLE_IRQ_TELA) {
+    muda_irq(self, IRQ_TELA, valor != 0);
+    return ERR_OK;
+  }
   // cada terminal tem 4 dispositivos:
   //   leitura, estado da leitura, escrita, estado da escrita
   int term = id / 4;
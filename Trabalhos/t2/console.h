@@ -12,16 +12,24 @@
 
 #include <stdbool.h>
 #include "es.h"
+#include "pic.h"
 
 typedef struct console_t console_t;
 
 // cria e inicializa a console
+// a console pede interrupção ao controlador 'pic' (IRQ_TECLADO ou
+//   IRQ_TELA) quando um terminal passa a ter caractere para ser lido ou
+//   volta a aceitar escrita
 // retorna NULL em caso de erro
-console_t *console_cria(void);
+console_t *console_cria(pic_t *pic);
 
 // destrói a console
 void console_destroi(console_t *self);
 
+// retorna true se a console é interativa (tem um operador controlando a
+//   execução), false se a execução é em lote (ver console_lote.c)
+bool console_interativa(console_t *self);
+
 // imprime na área geral do console
 int console_printf(console_t *self, char *fmt, ...);
 
@@ -38,10 +46,33 @@ char console_processa_entrada(console_t *self);
 void console_tictac(console_t *self);
 
 // esta função deve ser chamada para desenhar a tela da console
+// a tela só é redesenhada algumas vezes por segundo (ver
+//   console_define_quadros_por_segundo), e só as partes que mudaram
 void console_atualiza(console_t *self);
 
+// retorna true se já é hora de redesenhar a tela (a próxima chamada a
+//   console_atualiza vai desenhar) -- serve para evitar preparar o texto
+//   de status quando ele não vai ser mostrado
+bool console_hora_de_atualizar(console_t *self);
+
+// define quantas vezes por segundo (no máximo) a tela é redesenhada
+void console_define_quadros_por_segundo(console_t *self, int qps);
+
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
+// cada terminal t tem 4 dispositivos: 4t para ler do teclado, 4t+1 para
+//   saber se tem caractere para ler, 4t+2 para escrever na tela e 4t+3
+//   para saber se pode escrever
+// os dispositivos abaixo (um para o teclado, um para a tela) contêm 1 se
+//   a console está pedindo a interrupção correspondente; escrever 0
+//   desliga o pedido
+// o dispositivo CONSOLE_ENTRADA_ESGOTADA (só leitura) tem o bit t ligado
+//   se a entrada do terminal t acabou (não vai mais ter caractere para
+//   ler); só acontece na execução em lote, com a entrada vinda de arquivo
+//   -- na console interativa o operador sempre pode digitar mais
+#define CONSOLE_IRQ_TECLADO 16
+#define CONSOLE_IRQ_TELA    17
+#define CONSOLE_ENTRADA_ESGOTADA 18
 err_t term_le(void *disp, int id, int *pvalor);
 err_t term_escr(void *disp, int id, int valor);
 
@@ -0,0 +1,260 @@
+// implementação da console para execução em lote (sem curses)
+//
+// tem a mesma interface que console.c, para ser ligada no lugar dela
+//   (ver alvo main_lote no Makefile)
+// - a saída de cada terminal vai para a saída padrão, uma linha por vez,
+//   precedida pela letra do terminal ("a: ...")
+// - a entrada de cada terminal vem do arquivo "entrada_a" (para o terminal
+//   a, "entrada_b" para o b etc), se existir; o conteúdo do arquivo fica
+//   todo disponível para leitura desde o início da execução
+// - as mensagens da console (console_printf) vão para a saída de erro,
+//   inclusive as estatísticas impressas no fim da execução (para tê-las em
+//   arquivo, ver a opção -S do main)
+// - a execução começa sem esperar comando do operador, e não tem comandos
+//   de operador
+// - como a entrada está toda disponível desde o início, a interrupção do
+//   teclado é pedida na criação, se algum terminal tiver entrada; a tela
+//   sempre aceita escrita, nunca pede interrupção
+// - quando toda a entrada de um terminal foi lida (ou se ele não tem
+//   arquivo de entrada), a console informa que a entrada dele acabou
+//   (dispositivo CONSOLE_ENTRADA_ESGOTADA), para o SO saber que quem
+//   espera para ler nele não vai ser atendido
+
+#include "console.h"
+
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define N_TERM 4   // número de terminais
+#define N_COL 80   // tamanho máximo de uma linha de saída
+
+// dados para cada terminal
+typedef struct {
+  // texto lido do arquivo de entrada, esperando para ser lido
+  char *entrada;
+  int tam_entrada;
+  int pos_entrada;
+  // linha de saída sendo montada
+  char saida[N_COL+1];
+  int tam_saida;
+} term_t;
+
+struct console_t {
+  term_t term[N_TERM];
+  bool ja_iniciou;
+  pic_t *pic;
+  bool irq_teclado;
+};
+
+// funções auxiliares
+static void le_arquivo_de_entrada(term_t *termp, char *nome);
+static void esvazia_saida(console_t *self, int t);
+
+console_t *console_cria(pic_t *pic)
+{
+  console_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+
+  self->pic = pic;
+  self->irq_teclado = false;
+  for (int t = 0; t < N_TERM; t++) {
+    char nome[20];
+    sprintf(nome, "entrada_%c", 'a' + t);
+    le_arquivo_de_entrada(&self->term[t], nome);
+    self->term[t].tam_saida = 0;
+    if (self->term[t].tam_entrada > 0) self->irq_teclado = true;
+  }
+  if (self->irq_teclado && pic != NULL) {
+    pic_sinaliza(pic, IRQ_TECLADO, true);
+  }
+  self->ja_iniciou = false;
+
+  return self;
+}
+
+void console_destroi(console_t *self)
+{
+  for (int t = 0; t < N_TERM; t++) {
+    if (self->term[t].tam_saida > 0) {
+      esvazia_saida(self, t);
+    }
+    free(self->term[t].entrada);
+  }
+  fflush(stdout);
+  free(self);
+}
+
+bool console_interativa(console_t *self)
+{
+  return false;
+}
+
+// lê todo o conteúdo do arquivo para a entrada do terminal
+static void le_arquivo_de_entrada(term_t *termp, char *nome)
+{
+  termp->entrada = NULL;
+  termp->tam_entrada = 0;
+  termp->pos_entrada = 0;
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) return;
+  int cap = 0;
+  int ch;
+  while ((ch = fgetc(arq)) != EOF) {
+    if (termp->tam_entrada >= cap) {
+      cap = cap == 0 ? 256 : cap * 2;
+      char *nova = realloc(termp->entrada, cap);
+      if (nova == NULL) break;
+      termp->entrada = nova;
+    }
+    termp->entrada[termp->tam_entrada++] = ch;
+  }
+  fclose(arq);
+}
+
+
+// SAIDA
+
+static void esvazia_saida(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  termp->saida[termp->tam_saida] = '\0';
+  printf("%c: %s\n", 'a' + t, termp->saida);
+  termp->tam_saida = 0;
+}
+
+static void imprime_no_term(console_t *self, int t, char ch)
+{
+  term_t *termp = &self->term[t];
+  if (ch == '\n') {
+    esvazia_saida(self, t);
+    return;
+  }
+  termp->saida[termp->tam_saida++] = ch;
+  if (termp->tam_saida >= N_COL) {
+    esvazia_saida(self, t);
+  }
+}
+
+
+// ENTRADA
+
+static bool tem_char_no_term(console_t *self, int t)
+{
+  return self->term[t].pos_entrada < self->term[t].tam_entrada;
+}
+
+static char remove_char_do_term(console_t *self, int t)
+{
+  term_t *termp = &self->term[t];
+  return termp->entrada[termp->pos_entrada++];
+}
+
+
+// CONSOLE
+
+void console_print_status(console_t *self, char *txt)
+{
+  // não tem linha de status
+}
+
+int console_printf(console_t *self, char *formato, ...)
+{
+  va_list arg;
+  va_start(arg, formato);
+  int r = vfprintf(stderr, formato, arg);
+  va_end(arg);
+  // as mensagens podem ou não terminar com \n
+  int tam = strlen(formato);
+  if (tam == 0 || formato[tam - 1] != '\n') {
+    fputc('\n', stderr);
+  }
+  return r;
+}
+
+char console_processa_entrada(console_t *self)
+{
+  // na primeira chamada, manda o controlador executar
+  if (!self->ja_iniciou) {
+    self->ja_iniciou = true;
+    return 'C';
+  }
+  return '\0';
+}
+
+void console_tictac(console_t *self)
+{
+  // não tem rolamento de tela nem entrada interativa
+}
+
+void console_atualiza(console_t *self)
+{
+  // não tem tela
+}
+
+bool console_hora_de_atualizar(console_t *self)
+{
+  return false;
+}
+
+void console_define_quadros_por_segundo(console_t *self, int qps)
+{
+}
+
+
+err_t term_le(void *disp, int id, int *pvalor)
+{
+  console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO) {
+    *pvalor = self->irq_teclado ? 1 : 0;
+    return ERR_OK;
+  } else if (id == CONSOLE_IRQ_TELA) {
+    *pvalor = 0;
+    return ERR_OK;
+  } else if (id == CONSOLE_ENTRADA_ESGOTADA) {
+    *pvalor = 0;
+    for (int t = 0; t < N_TERM; t++) {
+      if (!tem_char_no_term(self, t)) *pvalor |= 1 << t;
+    }
+    return ERR_OK;
+  }
+  // cada terminal tem 4 dispositivos:
+  //   leitura, estado da leitura, escrita, estado da escrita
+  int term = id / 4;
+  int sub = id % 4;
+  if (term < 0 || term >= N_TERM) return ERR_DISP_INV;
+  switch (sub) {
+    case 0: // leitura do teclado
+      if (!tem_char_no_term(self, term)) return ERR_OCUP;
+      *pvalor = remove_char_do_term(self, term);
+      break;
+    case 1: // estado do teclado
+      *pvalor = tem_char_no_term(self, term) ? 1 : 0;
+      break;
+    case 2: // escrita na tela
+      return ERR_OP_INV;
+    case 3: // estado da tela -- sempre pode escrever
+      *pvalor = 1;
+      break;
+  }
+  return ERR_OK;
+}
+
+err_t term_escr(void *disp, int id, int valor)
+{
+  console_t *self = disp;
+  if (id == CONSOLE_IRQ_TECLADO) {
+    self->irq_teclado = (valor != 0);
+    if (self->pic != NULL) pic_sinaliza(self->pic, IRQ_TECLADO, valor != 0);
+    return ERR_OK;
+  } else if (id == CONSOLE_IRQ_TELA) {
+    return ERR_OK;
+  }
+  int term = id / 4;
+  int sub = id % 4;
+  if (term < 0 || term >= N_TERM) return ERR_DISP_INV;
+  if (sub != 2) return ERR_OP_INV;
+  imprime_no_term(self, term, valor);
+  return ERR_OK;
+}
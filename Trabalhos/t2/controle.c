@@ -3,20 +3,48 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+
+// número máximo de instruções executadas de uma vez, sem passar pelos
+//   dispositivos e pela console
+#define INSTR_POR_LOTE 1000
+
+// tempo (em us de tempo real) que o laço dorme a cada volta quando não
+//   está executando, para não ocupar a CPU real esperando o operador
+#define ESPERA_PARADO 5000
+
+// número máximo de mensagens do log mostradas a cada redesenho da console
+//   (não adianta montar mais que as linhas que cabem na tela)
+#define MAX_LOG_POR_QUADRO 14
 
 struct controle_t {
   cpu_t *cpu;
   relogio_t *relogio;
   console_t *console;
+  log_t *log;
   enum { executando, passo, parado, fim } estado;
+  // resultado da execução (ver controle_laco)
+  int codigo_termino;
+  // tempo (do relógio) passado com a CPU ociosa, esperando interrupção
+  long t_ocioso;
+  // número máximo de instruções a executar (0 para sem limite)
+  long limite;
+  // tempo real da execução de controle_laco, em segundos
+  double t_real;
 };
 
 // funções auxiliares
+static void controle_executa_lote(controle_t *self);
+static int controle_tempo_ate_evento(controle_t *self);
 static void controle_processa_teclado(controle_t *self);
 static void controle_atualiza_console(controle_t *self);
+static void controle_mostra_log(controle_t *self, int max);
+static void controle_verifica_fim(controle_t *self, cpu_motivo_t motivo);
+static void controle_imprime_estatisticas(controle_t *self, double segundos);
 
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio,
+                          log_t *log)
 {
   controle_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
@@ -24,7 +52,12 @@ controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
   self->cpu = cpu;
   self->console = console;
   self->relogio = relogio;
+  self->log = log;
   self->estado = parado;
+  self->codigo_termino = 0;
+  self->t_ocioso = 0;
+  self->limite = 0;
+  self->t_real = 0;
 
   return self;
 }
@@ -34,31 +67,117 @@ void controle_destroi(controle_t *self)
   free(self);
 }
 
-void controle_laco(controle_t *self)
+void controle_define_limite(controle_t *self, long n_instrucoes)
+{
+  self->limite = n_instrucoes;
+}
+
+double controle_tempo_real(controle_t *self)
 {
+  return self->t_real;
+}
+
+long controle_tempo_ocioso(controle_t *self)
+{
+  return self->t_ocioso;
+}
+
+int controle_laco(controle_t *self)
+{
+  struct timespec t_ini, t_fim;
+  clock_gettime(CLOCK_MONOTONIC, &t_ini);
   // executa uma instrução por vez até a console dizer que chega
   do {
-    if (self->estado == passo || self->estado == executando) {
+    if (self->estado == executando) {
+      controle_executa_lote(self);
+    } else if (self->estado == passo) {
       cpu_executa_1(self->cpu);
       rel_tictac(self->relogio);
       console_tictac(self->console);
-      // enquanto não tem controlador de interrupção, fala direto com o relógio
-      // o dispositivo 3 do relógio contém 1 se o timer expirou
-      int tem_int;
-      rel_le(self->relogio, 3, &tem_int);
-      if (tem_int != 0) {
-        cpu_interrompe(self->cpu, IRQ_RELOGIO);
-      }
+    } else if (self->estado == parado) {
+      struct timespec espera = { 0, ESPERA_PARADO * 1000L };
+      nanosleep(&espera, NULL);
     }
     controle_processa_teclado(self);
     controle_atualiza_console(self);
   } while (self->estado != fim);
+  controle_mostra_log(self, MAX_LOG_POR_QUADRO);
+
+  clock_gettime(CLOCK_MONOTONIC, &t_fim);
+  double segundos = (t_fim.tv_sec - t_ini.tv_sec)
+                    + (t_fim.tv_nsec - t_ini.tv_nsec) / 1e9;
+  self->t_real = segundos;
 
   console_printf(self->console, "Fim da execução.");
-  console_printf(self->console, "relógio: %d\n", rel_agora(self->relogio));
+  controle_imprime_estatisticas(self, segundos);
+  return self->codigo_termino;
 }
  
 
+// executa instruções até o próximo evento (ou até INSTR_POR_LOTE), e
+//   avança o relógio de uma vez pelo número de instruções executadas
+// se a CPU está ociosa (esperando interrupção), não tem o que executar até
+//   o próximo evento, e o relógio avança direto até ele
+static void controle_executa_lote(controle_t *self)
+{
+  int t_evento = controle_tempo_ate_evento(self);
+  cpu_motivo_t motivo;
+  int t_passado;
+  if (cpu_esperando_irq(self->cpu)) {
+    motivo = CPU_MOT_PARADA;
+    t_passado = (t_evento > 0) ? t_evento : 1;
+    self->t_ocioso += t_passado;
+  } else {
+    // o lote não pode passar do momento do próximo evento, nem do limite
+    //   de instruções
+    int n = INSTR_POR_LOTE;
+    if (t_evento > 0 && t_evento < n) {
+      n = t_evento;
+    }
+    if (self->limite > 0) {
+      long resta = self->limite - cpu_num_instrucoes(self->cpu);
+      if (resta < n) n = resta;
+    }
+    t_passado = cpu_executa_n(self->cpu, n, &motivo);
+    // o tempo passa mesmo com a CPU parada
+    if (t_passado == 0) t_passado = 1;
+  }
+  rel_avanca(self->relogio, t_passado);
+  console_tictac(self->console);
+  controle_verifica_fim(self, motivo);
+  if (self->limite > 0 && cpu_num_instrucoes(self->cpu) >= self->limite) {
+    self->estado = fim;
+  }
+}
+
+// retorna quanto tempo falta para o próximo evento previsto nos
+//   dispositivos, ou 0 se não tem evento previsto
+// por enquanto, o único dispositivo com eventos em momento conhecido é o
+//   relógio (a interrupção programada); a console depende do operador
+static int controle_tempo_ate_evento(controle_t *self)
+{
+  int t_ate_interrupcao;
+  rel_le(self->relogio, 2, &t_ate_interrupcao);
+  return t_ate_interrupcao;
+}
+
+// em execução em lote, termina quando a CPU não tem mais como executar:
+//   parada ou com erro em modo supervisor (não aceita interrupção)
+// o código de término é 0 só se a CPU parou normalmente (o SO não tem mais
+//   processo); com erro é 1, inclusive quando o SO para a CPU porque os
+//   processos que restam estão bloqueados esperando entrada de terminais
+//   que não vão ter mais (ver CONSOLE_ENTRADA_ESGOTADA em console.h)
+static void controle_verifica_fim(controle_t *self, cpu_motivo_t motivo)
+{
+  if (console_interativa(self->console)) return;
+  if (motivo != CPU_MOT_PARADA && motivo != CPU_MOT_ERRO) return;
+  if (cpu_aceita_irq(self->cpu)) return;
+  self->estado = fim;
+  self->codigo_termino = (motivo == CPU_MOT_PARADA) ? 0 : 1;
+}
+
+
+
 static void controle_processa_teclado(controle_t *self)
 {
   if (self->estado == passo) self->estado = parado;
@@ -79,9 +198,51 @@ static void controle_processa_teclado(controle_t *self)
   }
 }
 
+static void controle_imprime_estatisticas(controle_t *self, double segundos)
+{
+  int agora = rel_agora(self->relogio);
+  long instrucoes = cpu_num_instrucoes(self->cpu);
+  console_printf(self->console, "relógio: %d", agora);
+  console_printf(self->console, "instruções executadas: %ld", instrucoes);
+  console_printf(self->console, "tempo ocioso: %ld", self->t_ocioso);
+  for (irq_t irq = 0; irq < N_IRQ; irq++) {
+    long n = cpu_num_irq(self->cpu, irq);
+    if (n > 0) {
+      console_printf(self->console, "IRQ %d (%s): %ld", irq, irq_nome(irq), n);
+    }
+  }
+  console_printf(self->console, "tempo real: %.3f s", segundos);
+  if (segundos > 0) {
+    console_printf(self->console, "instruções por segundo: %.0f",
+                   instrucoes / segundos);
+  }
+}
+
 static void controle_atualiza_console(controle_t *self)
 {
+  // sem tela, as mensagens do log são mostradas todas, na ordem
+  if (!console_interativa(self->console)) {
+    controle_mostra_log(self, 0);
+  }
+  // a descrição da CPU é cara para montar, só faz se for ser mostrada
+  if (!console_hora_de_atualizar(self->console)) return;
+  controle_mostra_log(self, MAX_LOG_POR_QUADRO);
   char *status = cpu_descricao(self->cpu);
   console_print_status(self->console, status);
   console_atualiza(self->console);
 }
+
+static void controle__imprime_linha_do_log(void *arg, char *linha)
+{
+  console_t *console = arg;
+  console_printf(console, "%s", linha);
+}
+
+// passa para a console as mensagens novas do log (no máximo 'max', se
+//   maior que 0)
+static void controle_mostra_log(controle_t *self, int max)
+{
+  if (self->log == NULL) return;
+  log_mostra_novas(self->log, max, controle__imprime_linha_do_log,
+                   self->console);
+}
@@ -13,11 +13,32 @@ typedef struct controle_t controle_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
+#include "log.h"
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio);
+// as mensagens registradas em 'log' são mostradas na console
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio,
+                          log_t *log);
 void controle_destroi(controle_t *self);
 
 // o laço principal da simulação
-void controle_laco(controle_t *self);
+// executa até o operador mandar terminar ou, em execução em lote (console
+//   não interativa), até a CPU parar em modo supervisor (quando não tem
+//   mais nada para executar)
+// retorna o código de término: 0 se a execução terminou normalmente,
+//   1 se a CPU parou por um erro
+int controle_laco(controle_t *self);
+
+// define o número máximo de instruções que a CPU vai executar; quando
+//   chegar nele, controle_laco termina (com código 0)
+// 0 (o padrão) é sem limite
+void controle_define_limite(controle_t *self, long n_instrucoes);
+
+// retorna o tempo real (em segundos) que durou a última execução de
+//   controle_laco
+double controle_tempo_real(controle_t *self);
+
+// retorna o tempo (do relógio) em que a CPU ficou ociosa, esperando
+//   interrupção
+long controle_tempo_ocioso(controle_t *self);
 
 #endif // CONTROLE_H
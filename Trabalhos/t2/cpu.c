@@ -6,6 +6,34 @@
 #include <stdio.h>
 #include <string.h>
 
+// tipo das funções que implementam cada instrução
+// recebem o argumento da instrução já lido da memória (se ela tiver)
+typedef void (*func_op_t)(cpu_t *self, int A1);
+
+// cache de instruções pré-decodificadas
+// tem uma entrada para cada posição da memória física, com a função que
+//   implementa a instrução que está nessa posição e seu argumento, para que
+//   a execução não precise ler a memória nem decodificar o opcode.
+// as entradas são agrupadas por quadro físico (ou por uma fração de quadro
+//   de tamanho potência de 2, se o tamanho da página não for potência de 2,
+//   para localizar o grupo com deslocamento e não divisão); cada grupo
+//   tem um número
+//   de versão, que é incrementado cada vez que alguma posição do quadro é
+//   alterada na memória (a memória avisa a CPU). Uma entrada só é válida se
+//   tiver a mesma versão que o seu grupo. Assim, código que se
+//   automodifica (como CHAMA, que escreve o endereço de retorno na área do
+//   programa) continua funcionando.
+// o argumento só é guardado na entrada se estiver no mesmo grupo do opcode,
+//   porque a página seguinte pode estar mapeada em qualquer outro quadro
+typedef struct {
+  func_op_t exec;     // função que implementa a instrução
+  int opcode;         // opcode da instrução (-1 se inválido), para o perfil
+  int A1;             // argumento da instrução
+  bool tem_A1;        // a instrução tem argumento
+  bool A1_na_cache;   // o argumento está em A1 (senão, deve ser lido)
+  unsigned versao;    // versão do grupo quando a entrada foi preenchida
+} predec_t;
+
 // uma CPU tem estado, memória, controlador de ES
 struct cpu_t {
   // registradores
@@ -19,18 +47,46 @@ struct cpu_t {
   // acesso a dispositivos externos
   mmu_t *mmu;
   es_t *es;
+  pic_t *pic;
+  // se o controlador tem interrupção para entregar (mantido pelo aviso do
+  //   controlador, para não ter que perguntar a cada instrução)
+  bool irq_no_pic;
   // função e argumento para implementar instrução CHAMAC
   func_chamaC_t funcaoC;
   void *argC;
+  // se aceitou interrupção (para cpu_executa_n saber que deve parar)
+  bool interrompeu;
+  // estado salvo na interrupção, e se também deve ser colocado na memória
+  cpu_estado_t salvo;
+  bool estado_na_memoria;
+  // estatísticas
+  long n_instrucoes;
+  long n_irq[N_IRQ];
+  // perfil de execução, NULL se não estiver contando
+  perfil_t *perfil;
+  // instruções pré-decodificadas
+  mem_t *mem;
+  predec_t *predec;
+  unsigned *versao_grupo;
+  int bits_grupo;     // log2 do tamanho de um grupo de entradas
 };
 
-cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
+// funções auxiliares para a cache de instruções
+static bool cpu__cria_predec(cpu_t *self);
+static void cpu__memoria_alterada(void *arg, int endereco, int n);
+static void cpu__aviso_pic(void *arg, bool tem_irq);
+// funções auxiliares para o estado salvo em memória
+static void cpu__poe_estado_na_memoria(cpu_t *self);
+static void cpu__pega_estado_da_memoria(cpu_t *self);
+
+cpu_t *cpu_cria(mmu_t *mmu, es_t *es, pic_t *pic)
 {
   cpu_t *self;
   self = malloc(sizeof(*self));
   if (self != NULL) {
     self->mmu = mmu;
     self->es = es;
+    self->pic = pic;
     // inicializa registradores
     self->PC = 0;
     self->A = 0;
@@ -39,6 +95,18 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
     self->complemento = 0;
     self->modo = supervisor;
     self->funcaoC = NULL;
+    self->interrompeu = false;
+    self->estado_na_memoria = true;
+    self->n_instrucoes = 0;
+    self->perfil = NULL;
+    for (int i = 0; i < N_IRQ; i++) {
+      self->n_irq[i] = 0;
+    }
+    if (!cpu__cria_predec(self)) {
+      free(self);
+      return NULL;
+    }
+    pic_define_obs_irq(pic, cpu__aviso_pic, self);
     // gera uma interrupção de reset
     cpu_interrompe(self, IRQ_RESET);
   }
@@ -48,6 +116,10 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
 void cpu_destroi(cpu_t *self)
 {
   // eu nao criei MMU nem es; quem criou que destrua!
+  mem_define_obs_alteracao(self->mem, NULL, NULL);
+  pic_define_obs_irq(self->pic, NULL, NULL);
+  free(self->predec);
+  free(self->versao_grupo);
   free(self);
 }
 
@@ -55,16 +127,18 @@ char *cpu_descricao(cpu_t *self)
 {
   static char descr[100]; 
   // imprime registradores, opcode, instrução
+  // a memória é lida sem passar pela TLB nem marcar acesso: mostrar o
+  //   estado da CPU não pode alterar o que está sendo simulado
   int opcode = -1;
-  mmu_le(self->mmu, self->PC, &opcode, self->modo);
+  mmu_espia(self->mmu, self->PC, &opcode, self->modo);
   sprintf(descr, "%sPC=%04d A=%06d X=%06d %02d %s",
                  self->modo == supervisor ? "🦸" : "🏃",
                  self->PC, self->A, self->X, opcode, instrucao_nome(opcode));
   // imprime argumento da instrução, se houver
   if (instrucao_num_args(opcode) > 0) {
     char aux[40];
-    int A1;
-    mmu_le(self->mmu, self->PC + 1, &A1, self->modo);
+    int A1 = 0;
+    mmu_espia(self->mmu, self->PC + 1, &A1, self->modo);
     sprintf(aux, " %d", A1);
     strcat(descr, aux);
   }
@@ -92,12 +166,6 @@ static bool pega_mem(cpu_t *self, int endereco, int *pval)
   return false;
 }
 
-// lê o opcode da instrução no PC
-static bool pega_opcode(cpu_t *self, int *popc)
-{
-  return pega_mem(self, self->PC, popc);
-}
-
 // lê o argumento 1 da instrução no PC
 static bool pega_A1(cpu_t *self, int *pA1)
 {
@@ -134,12 +202,12 @@ static bool poe_es(cpu_t *self, int dispositivo, int val)
 // ---------------------------------------------------------------------
 // funções auxiliares para implementação de cada instrução
 
-static void op_NOP(cpu_t *self) // não faz nada
+static void op_NOP(cpu_t *self, int A1) // não faz nada
 {
   self->PC += 1;
 }
 
-static void op_PARA(cpu_t *self) // para a CPU
+static void op_PARA(cpu_t *self, int A1) // para a CPU
 {
   if (self->modo == usuario) {
     self->erro = ERR_INSTR_PRIV;
@@ -148,52 +216,47 @@ static void op_PARA(cpu_t *self) // para a CPU
   self->erro = ERR_CPU_PARADA;
 }
 
-static void op_CARGI(cpu_t *self) // carrega imediato
+static void op_CARGI(cpu_t *self, int A1) // carrega imediato
 {
-  int A1;
-  if (pega_A1(self, &A1)) {
-    self->A = A1;
-    self->PC += 2;
-  }
+  self->A = A1;
+  self->PC += 2;
 }
 
-static void op_CARGM(cpu_t *self) // carrega da memória
+static void op_CARGM(cpu_t *self, int A1) // carrega da memória
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A = mA1;
     self->PC += 2;
   }
 }
 
-static void op_CARGX(cpu_t *self) // carrega indexado
+static void op_CARGX(cpu_t *self, int A1) // carrega indexado
 {
-  int A1, mA1mX;
+  int mA1mX;
   int X = self->X;
-  if (pega_A1(self, &A1) && pega_mem(self, A1 + X, &mA1mX)) {
+  if (pega_mem(self, A1 + X, &mA1mX)) {
     self->A = mA1mX;
     self->PC += 2;
   }
 }
 
-static void op_ARMM(cpu_t *self) // armazena na memória
+static void op_ARMM(cpu_t *self, int A1) // armazena na memória
 {
-  int A1;
-  if (pega_A1(self, &A1) && poe_mem(self, A1, self->A)) {
+  if (poe_mem(self, A1, self->A)) {
     self->PC += 2;
   }
 }
 
-static void op_ARMX(cpu_t *self) // armazena indexado
+static void op_ARMX(cpu_t *self, int A1) // armazena indexado
 {
-  int A1;
   int X = self->X;
-  if (pega_A1(self, &A1) && poe_mem(self, A1 + X, self->A)) {
+  if (poe_mem(self, A1 + X, self->A)) {
     self->PC += 2;
   }
 }
 
-static void op_TRAX(cpu_t *self) // troca A com X
+static void op_TRAX(cpu_t *self, int A1) // troca A com X
 {
   int A = self->A;
   int X = self->X;
@@ -202,150 +265,145 @@ static void op_TRAX(cpu_t *self) // troca A com X
   self->PC += 1;
 }
 
-static void op_CPXA(cpu_t *self) // copia X para A
+static void op_CPXA(cpu_t *self, int A1) // copia X para A
 {
   self->A = self->X;
   self->PC += 1;
 }
 
-static void op_INCX(cpu_t *self) // incrementa X
+static void op_INCX(cpu_t *self, int A1) // incrementa X
 {
   self->X += 1;
   self->PC += 1;
 }
 
-static void op_SOMA(cpu_t *self) // soma
+static void op_SOMA(cpu_t *self, int A1) // soma
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A += mA1;
     self->PC += 2;
   }
 }
 
-static void op_SUB(cpu_t *self) // subtração
+static void op_SUB(cpu_t *self, int A1) // subtração
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A -= mA1;
     self->PC += 2;
   }
 }
 
-static void op_MULT(cpu_t *self) // multiplicação
+static void op_MULT(cpu_t *self, int A1) // multiplicação
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A *= mA1;
     self->PC += 2;
   }
 }
 
-static void op_DIV(cpu_t *self) // divisão
+static void op_DIV(cpu_t *self, int A1) // divisão
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A /= mA1;
     self->PC += 2;
   }
 }
 
-static void op_RESTO(cpu_t *self) // resto
+static void op_RESTO(cpu_t *self, int A1) // resto
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A %= mA1;
     self->PC += 2;
   }
 }
 
-static void op_NEG(cpu_t *self) // inverte sinal
+static void op_NEG(cpu_t *self, int A1) // inverte sinal
 {
   self->A = -self->A;
   self->PC += 1;
 }
 
-static void op_DESV(cpu_t *self) // desvio incondicional
+static void op_DESV(cpu_t *self, int A1) // desvio incondicional
 {
-  int A1;
-  if (pega_A1(self, &A1)) {
-    self->PC = A1;
-  }
+  self->PC = A1;
 }
 
-static void op_DESVZ(cpu_t *self) // desvio condicional
+static void op_DESVZ(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A == 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVNZ(cpu_t *self) // desvio condicional
+static void op_DESVNZ(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A != 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVN(cpu_t *self) // desvio condicional
+static void op_DESVN(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A < 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVP(cpu_t *self) // desvio condicional
+static void op_DESVP(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A > 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_CHAMA(cpu_t *self) // chamada de subrotina
+static void op_CHAMA(cpu_t *self, int A1) // chamada de subrotina
 {
-  int A1;
-  if (pega_A1(self, &A1) && poe_mem(self, A1, self->PC + 2)) {
+  if (poe_mem(self, A1, self->PC + 2)) {
     self->PC = A1 + 1;
   }
 }
 
-static void op_RET(cpu_t *self) // retorno de subrotina
+static void op_RET(cpu_t *self, int A1) // retorno de subrotina
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->PC = mA1;
   }
 }
 
-static void op_LE(cpu_t *self) // leitura de E/S
+static void op_LE(cpu_t *self, int A1) // leitura de E/S
 {
   if (self->modo == usuario) {
     self->erro = ERR_INSTR_PRIV;
     return;
   }
-  int A1, dado;
-  if (pega_A1(self, &A1) && pega_es(self, A1, &dado)) {
+  int dado;
+  if (pega_es(self, A1, &dado)) {
     self->A = dado;
     self->PC += 2;
   }
 }
 
-static void op_ESCR(cpu_t *self) // escrita de E/S
+static void op_ESCR(cpu_t *self, int A1) // escrita de E/S
 {
   if (self->modo == usuario) {
     self->erro = ERR_INSTR_PRIV;
     return;
   }
-  int A1;
-  if (pega_A1(self, &A1) && poe_es(self, A1, self->A)) {
+  if (poe_es(self, A1, self->A)) {
     self->PC += 2;
   }
 }
@@ -353,7 +411,7 @@ static void op_ESCR(cpu_t *self) // escrita de E/S
 // declara uma função auxiliar (só para a interrupção e o retorno ficarem perto)
 static void cpu_desinterrompe(cpu_t *self);
 
-static void op_RETI(cpu_t *self) // retorno de interrupção
+static void op_RETI(cpu_t *self, int A1) // retorno de interrupção
 {
   if (self->modo == usuario) {
     self->erro = ERR_INSTR_PRIV;
@@ -362,7 +420,7 @@ static void op_RETI(cpu_t *self) // retorno de interrupção
   cpu_desinterrompe(self);
 }
 
-static void op_CHAMAC(cpu_t *self) // chama função em C
+static void op_CHAMAC(cpu_t *self, int A1) // chama função em C
 {
   if (self->modo == usuario) {
     self->erro = ERR_INSTR_PRIV;
@@ -376,7 +434,7 @@ static void op_CHAMAC(cpu_t *self) // chama função em C
   self->PC += 1;
 }
 
-static void op_CHAMAS(cpu_t *self) // chamada de sistema
+static void op_CHAMAS(cpu_t *self, int A1) // chamada de sistema
 {
   self->PC += 1;
   // causa uma interrupção, para forçar a execução do SO
@@ -384,48 +442,177 @@ static void op_CHAMAS(cpu_t *self) // chamada de sistema
 
 }
 
-void cpu_executa_1(cpu_t *self)
+static void op_invalida(cpu_t *self, int A1) // opcode desconhecido
+{
+  self->erro = ERR_INSTR_INV;
+}
+
+// função que implementa cada instrução, indexada pelo opcode
+static func_op_t tab_op[] = {
+  [NOP]    = op_NOP,
+  [PARA]   = op_PARA,
+  [CARGI]  = op_CARGI,
+  [CARGM]  = op_CARGM,
+  [CARGX]  = op_CARGX,
+  [ARMM]   = op_ARMM,
+  [ARMX]   = op_ARMX,
+  [TRAX]   = op_TRAX,
+  [CPXA]   = op_CPXA,
+  [INCX]   = op_INCX,
+  [SOMA]   = op_SOMA,
+  [SUB]    = op_SUB,
+  [MULT]   = op_MULT,
+  [DIV]    = op_DIV,
+  [RESTO]  = op_RESTO,
+  [NEG]    = op_NEG,
+  [DESV]   = op_DESV,
+  [DESVZ]  = op_DESVZ,
+  [DESVNZ] = op_DESVNZ,
+  [DESVN]  = op_DESVN,
+  [DESVP]  = op_DESVP,
+  [CHAMA]  = op_CHAMA,
+  [RET]    = op_RET,
+  [LE]     = op_LE,
+  [ESCR]   = op_ESCR,
+  [RETI]   = op_RETI,
+  [CHAMAC] = op_CHAMAC,
+  [CHAMAS] = op_CHAMAS,
+};
+#define N_OP (sizeof(tab_op) / sizeof(tab_op[0]))
+
+
+// ---------------------------------------------------------------------
+// cache de instruções pré-decodificadas
+
+static bool cpu__cria_predec(cpu_t *self)
+{
+  self->mem = mmu_mem(self->mmu);
+  int tam_mem = mem_tam(self->mem);
+  // o grupo é a maior potência de 2 que divide o tamanho da página, assim
+  //   um grupo nunca tem partes de duas páginas
+  int tam_pagina = mmu_tam_pagina(self->mmu);
+  self->bits_grupo = 0;
+  while (tam_pagina % (2 << self->bits_grupo) == 0) {
+    self->bits_grupo++;
+  }
+  int n_grupos = (tam_mem >> self->bits_grupo) + 1;
+  // com calloc, as entradas têm versão 0 e os grupos versão 1: tudo inválido
+  self->predec = calloc(tam_mem, sizeof(*self->predec));
+  self->versao_grupo = malloc(n_grupos * sizeof(*self->versao_grupo));
+  if (self->predec == NULL || self->versao_grupo == NULL) {
+    free(self->predec);
+    free(self->versao_grupo);
+    return false;
+  }
+  for (int g = 0; g < n_grupos; g++) {
+    self->versao_grupo[g] = 1;
+  }
+  mem_define_obs_alteracao(self->mem, cpu__memoria_alterada, self);
+  return true;
+}
+
+// chamada pela memória quando seu conteúdo é alterado: invalida as entradas
+//   da cache de todos os grupos alterados
+static void cpu__memoria_alterada(void *arg, int endereco, int n)
 {
-  // não executa se CPU já estiver em erro
-  if (self->erro != ERR_OK) return;
+  cpu_t *self = arg;
+  int g_ini = endereco >> self->bits_grupo;
+  int g_fim = (endereco + n - 1) >> self->bits_grupo;
+  for (int g = g_ini; g <= g_fim; g++) {
+    self->versao_grupo[g]++;
+  }
+}
 
+// preenche a entrada da cache correspondente ao endereço físico 'endfis'
+static void cpu__decodifica(cpu_t *self, int endfis, predec_t *instr)
+{
   int opcode;
-  if (!pega_opcode(self, &opcode)) return;
-
-  switch (opcode) {
-    case NOP:    op_NOP(self);    break;
-    case PARA:   op_PARA(self);   break;
-    case CARGI:  op_CARGI(self);  break;
-    case CARGM:  op_CARGM(self);  break;
-    case CARGX:  op_CARGX(self);  break;
-    case ARMM:   op_ARMM(self);   break;
-    case ARMX:   op_ARMX(self);   break;
-    case TRAX:   op_TRAX(self);   break;
-    case CPXA:   op_CPXA(self);   break;
-    case INCX:   op_INCX(self);   break;
-    case SOMA:   op_SOMA(self);   break;
-    case SUB:    op_SUB(self);    break;
-    case MULT:   op_MULT(self);   break;
-    case DIV:    op_DIV(self);    break;
-    case RESTO:  op_RESTO(self);  break;
-    case NEG:    op_NEG(self);    break;
-    case DESV:   op_DESV(self);   break;
-    case DESVZ:  op_DESVZ(self);  break;
-    case DESVNZ: op_DESVNZ(self); break;
-    case DESVN:  op_DESVN(self);  break;
-    case DESVP:  op_DESVP(self);  break;
-    case CHAMA:  op_CHAMA(self);  break;
-    case RET:    op_RET(self);    break;
-    case LE:     op_LE(self);     break;
-    case ESCR:   op_ESCR(self);   break;
-    case RETI:   op_RETI(self);   break;
-    case CHAMAC: op_CHAMAC(self); break;
-    case CHAMAS: op_CHAMAS(self); break;
-    default:     self->erro = ERR_INSTR_INV;
-  }
-
-  if (self->erro != ERR_OK && self->erro != ERR_CPU_PARADA && self->modo == usuario) {
-    cpu_interrompe(self, IRQ_ERR_CPU);
+  mem_le(self->mem, endfis, &opcode);
+  if (opcode >= 0 && opcode < N_OP && tab_op[opcode] != NULL) {
+    instr->exec = tab_op[opcode];
+    instr->opcode = opcode;
+    instr->tem_A1 = instrucao_num_args(opcode) > 0;
+  } else {
+    instr->exec = op_invalida;
+    instr->opcode = -1;
+    instr->tem_A1 = false;
+  }
+  instr->A1_na_cache = false;
+  int grupo = endfis >> self->bits_grupo;
+  if (instr->tem_A1 && ((endfis + 1) >> self->bits_grupo) == grupo) {
+    if (mem_le(self->mem, endfis + 1, &instr->A1) == ERR_OK) {
+      instr->A1_na_cache = true;
+    }
+  }
+  instr->versao = self->versao_grupo[grupo];
+}
+
+// retorna a instrução decodificada que está no PC, ou NULL em caso de erro
+static predec_t *cpu__busca_instrucao(cpu_t *self)
+{
+  int endfis;
+  self->erro = mmu_traduz(self->mmu, self->PC, &endfis, self->modo);
+  if (self->erro != ERR_OK) {
+    self->complemento = self->PC;
+    return NULL;
+  }
+  predec_t *instr = &self->predec[endfis];
+  if (instr->versao != self->versao_grupo[endfis >> self->bits_grupo]) {
+    cpu__decodifica(self, endfis, instr);
+  }
+  return instr;
+}
+
+// aceita a interrupção de dispositivo que o controlador tiver para a CPU,
+//   se tiver alguma e a CPU estiver em modo usuário
+// pode tirar a CPU do estado parado
+static void cpu__verifica_pic(cpu_t *self)
+{
+  if (self->irq_no_pic && self->modo == usuario) {
+    cpu_interrompe(self, pic_irq(self->pic));
+  }
+}
+
+// chamada pelo controlador de interrupções quando passa a ter (ou deixa de
+//   ter) interrupção para entregar
+static void cpu__aviso_pic(void *arg, bool tem_irq)
+{
+  cpu_t *self = arg;
+  self->irq_no_pic = tem_irq;
+}
+
+// as duas versões do laço de execução (ver cpu_executa.h)
+#define CPU_EXECUTA_1 cpu__executa_1
+#define CPU_EXECUTA_N cpu__executa_n
+#define CPU_COM_PERFIL 0
+#include "cpu_executa.h"
+#undef CPU_EXECUTA_1
+#undef CPU_EXECUTA_N
+#undef CPU_COM_PERFIL
+
+#define CPU_EXECUTA_1 cpu__executa_1_perfil
+#define CPU_EXECUTA_N cpu__executa_n_perfil
+#define CPU_COM_PERFIL 1
+#include "cpu_executa.h"
+#undef CPU_EXECUTA_1
+#undef CPU_EXECUTA_N
+#undef CPU_COM_PERFIL
+
+void cpu_executa_1(cpu_t *self)
+{
+  if (self->perfil != NULL) {
+    cpu__executa_1_perfil(self);
+  } else {
+    cpu__executa_1(self);
+  }
+}
+
+int cpu_executa_n(cpu_t *self, int n, cpu_motivo_t *pmotivo)
+{
+  if (self->perfil != NULL) {
+    return cpu__executa_n_perfil(self, n, pmotivo);
+  } else {
+    return cpu__executa_n(self, n, pmotivo);
   }
 }
 
@@ -434,33 +621,117 @@ bool cpu_interrompe(cpu_t *self, irq_t irq)
   // só aceita interrupção em modo usuário
   if (self->modo != usuario) return false;
   // esta é uma CPU boazinha, salva todo o estado interno da CPU
-  // poe em modo supervisor, para que o acesso seja feito na memória física
+  self->salvo.PC = self->PC;
+  self->salvo.A = self->A;
+  self->salvo.X = self->X;
+  self->salvo.erro = self->erro;
+  self->salvo.complemento = self->complemento;
+  self->salvo.modo = self->modo;
   self->modo = supervisor;
-  poe_mem(self, IRQ_END_PC,          self->PC);
-  poe_mem(self, IRQ_END_A,           self->A);
-  poe_mem(self, IRQ_END_X,           self->X);
-  poe_mem(self, IRQ_END_erro,        self->erro);
-  poe_mem(self, IRQ_END_complemento, self->complemento);
-  poe_mem(self, IRQ_END_modo,        usuario);
+  if (self->estado_na_memoria) {
+    cpu__poe_estado_na_memoria(self);
+  }
 
   self->A = irq;
   self->erro = ERR_OK;
   self->PC = 10;
+  self->interrompeu = true;
+  if (irq >= 0 && irq < N_IRQ) self->n_irq[irq]++;
 
   return true;
 }
 
 static void cpu_desinterrompe(cpu_t *self)
+{
+  if (self->estado_na_memoria) {
+    cpu__pega_estado_da_memoria(self);
+  }
+  self->PC = self->salvo.PC;
+  self->A = self->salvo.A;
+  self->X = self->salvo.X;
+  self->erro = self->salvo.erro;
+  self->complemento = self->salvo.complemento;
+  self->modo = self->salvo.modo;
+}
+
+void cpu_define_estado_na_memoria(cpu_t *self, bool na_memoria)
+{
+  self->estado_na_memoria = na_memoria;
+}
+
+void cpu_salva_estado(cpu_t *self, cpu_estado_t *estado)
+{
+  *estado = self->salvo;
+}
+
+void cpu_restaura_estado(cpu_t *self, const cpu_estado_t *estado)
+{
+  self->salvo = *estado;
+  if (self->estado_na_memoria) {
+    cpu__poe_estado_na_memoria(self);
+  }
+}
+
+// o estado em memória é acessado sempre com endereços físicos, e sem
+//   alterar o registrador de erro
+static void cpu__poe_estado_na_memoria(cpu_t *self)
+{
+  mmu_escreve(self->mmu, IRQ_END_PC,          self->salvo.PC, supervisor);
+  mmu_escreve(self->mmu, IRQ_END_A,           self->salvo.A, supervisor);
+  mmu_escreve(self->mmu, IRQ_END_X,           self->salvo.X, supervisor);
+  mmu_escreve(self->mmu, IRQ_END_erro,        self->salvo.erro, supervisor);
+  mmu_escreve(self->mmu, IRQ_END_complemento, self->salvo.complemento,
+              supervisor);
+  mmu_escreve(self->mmu, IRQ_END_modo,        self->salvo.modo, supervisor);
+}
+
+static void cpu__pega_estado_da_memoria(cpu_t *self)
 {
   int dado;
-  pega_mem(self, IRQ_END_PC,          &self->PC);
-  pega_mem(self, IRQ_END_A,           &self->A);
-  pega_mem(self, IRQ_END_X,           &self->X);
-  pega_mem(self, IRQ_END_erro,        &dado);
-  self->erro = dado;
-  pega_mem(self, IRQ_END_complemento, &self->complemento);
-  pega_mem(self, IRQ_END_modo,        &dado);
-  self->modo = dado;
+  mmu_le(self->mmu, IRQ_END_PC,          &self->salvo.PC, supervisor);
+  mmu_le(self->mmu, IRQ_END_A,           &self->salvo.A, supervisor);
+  mmu_le(self->mmu, IRQ_END_X,           &self->salvo.X, supervisor);
+  mmu_le(self->mmu, IRQ_END_erro,        &dado, supervisor);
+  self->salvo.erro = dado;
+  mmu_le(self->mmu, IRQ_END_complemento, &self->salvo.complemento,
+         supervisor);
+  mmu_le(self->mmu, IRQ_END_modo,        &dado, supervisor);
+  self->salvo.modo = dado;
+}
+
+bool cpu_aceita_irq(cpu_t *self)
+{
+  return self->modo == usuario;
+}
+
+bool cpu_esperando_irq(cpu_t *self)
+{
+  return self->erro == ERR_CPU_PARADA && self->modo == usuario
+         && !self->irq_no_pic;
+}
+
+long cpu_num_instrucoes(cpu_t *self)
+{
+  return self->n_instrucoes;
+}
+
+long cpu_num_irq(cpu_t *self, irq_t irq)
+{
+  if (irq < 0 || irq >= N_IRQ) return 0;
+  return self->n_irq[irq];
+}
+
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil)
+{
+  self->perfil = perfil;
+}
+
+void cpu_nomeia_tabpag(cpu_t *self, tabpag_t *tabpag, char *nome,
+                       simbolos_t *simbolos)
+{
+  if (self->perfil != NULL) {
+    perfil_nomeia_tabpag(self->perfil, tabpag, nome, simbolos);
+  }
 }
 
 void cpu_define_chamaC(cpu_t *self, func_chamaC_t funcaoC, void *argC)
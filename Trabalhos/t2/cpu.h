@@ -13,16 +13,31 @@
 #include "mmu.h"
 #include "es.h"
 #include "irq.h"
+#include "pic.h"
+#include "perfil.h"
 
 typedef struct cpu_t cpu_t; // tipo opaco
 
 // tipo da função a ser chamada quando executar a instrução CHAMAC
 typedef err_t (*func_chamaC_t)(void *argC, int reg_A);
 
+// estado da CPU que é salvo quando ela aceita uma interrupção, e
+//   recuperado quando executa RETI
+typedef struct {
+  int PC;
+  int A;
+  int X;
+  err_t erro;
+  int complemento;
+  cpu_modo_t modo;
+} cpu_estado_t;
 
-// cria uma unidade de execução com acesso à MMU e ao
-//   controlador de E/S fornecidos
-cpu_t *cpu_cria(mmu_t *mmu, es_t *es);
+
+// cria uma unidade de execução com acesso à MMU e aos
+//   controladores de E/S e de interrupções fornecidos
+// antes de cada instrução, se estiver em modo usuário, a CPU aceita a
+//   interrupção que o controlador de interrupções tiver para entregar
+cpu_t *cpu_cria(mmu_t *mmu, es_t *es, pic_t *pic);
 
 // destrói a unidade de execução
 void cpu_destroi(cpu_t *self);
@@ -30,13 +45,75 @@ void cpu_destroi(cpu_t *self);
 // executa uma instrução
 void cpu_executa_1(cpu_t *self);
 
+// motivos para o fim da execução de um lote de instruções
+typedef enum {
+  CPU_MOT_LIMITE,    // executou todas as instruções pedidas
+  CPU_MOT_IRQ,       // a CPU aceitou uma interrupção
+  CPU_MOT_PARADA,    // a CPU está parada (ERR_CPU_PARADA)
+  CPU_MOT_ERRO,      // a CPU está em outro estado de erro
+} cpu_motivo_t;
+
+// executa até 'n' instruções, sem passar pelo controlador entre elas
+// para antes se a CPU aceitar uma interrupção (chamada de sistema, erro
+//   em modo usuário ou dispositivo) ou ficar em estado de erro (inclusive
+//   por PARA)
+// coloca em '*pmotivo' o motivo do fim da execução
+// retorna o número de instruções executadas (uma instrução que causa erro
+//   ou interrupção é contada); retorna 0 se a CPU já estava em erro
+int cpu_executa_n(cpu_t *self, int n, cpu_motivo_t *pmotivo);
+
 // implementa uma interrupção
-// passa para modo supervisor, salva o estado da CPU no início da memória,
+// passa para modo supervisor, salva o estado da CPU (ver abaixo),
 //   altera A para identificar a requisição de interrupção, altera PC para
 //   o endereço do tratador de interrupção
 // retorna true se interrupção foi aceita ou false caso contrário
 bool cpu_interrompe(cpu_t *self, irq_t irq);
 
+// O estado da CPU no momento da interrupção é salvo em um banco de
+//   registradores interno, de onde é recuperado pela instrução RETI.
+// Em modo de compatibilidade (o padrão), o estado é também colocado na
+//   memória, a partir do endereço 0 (IRQ_END_* em irq.h), e RETI recupera
+//   o estado da memória (que pode ter sido alterado pelo SO).
+// Fora desse modo, o SO deve usar as funções abaixo para obter e alterar
+//   o estado, sem passar pela memória.
+
+// define se o estado salvo na interrupção vai também para a memória
+void cpu_define_estado_na_memoria(cpu_t *self, bool na_memoria);
+
+// copia para '*estado' o estado salvo na última interrupção
+void cpu_salva_estado(cpu_t *self, cpu_estado_t *estado);
+
+// altera o estado que será recuperado por RETI
+void cpu_restaura_estado(cpu_t *self, const cpu_estado_t *estado);
+
+// retorna true se a CPU aceitaria uma interrupção (está em modo usuário)
+// uma CPU parada em modo supervisor não tem como voltar a executar
+bool cpu_aceita_irq(cpu_t *self);
+
+// retorna true se a CPU está parada em modo usuário, esperando uma
+//   interrupção para voltar a executar (o SO não tem processo para
+//   executar), e não tem interrupção para ela no controlador
+bool cpu_esperando_irq(cpu_t *self);
+
+// retorna o número de instruções completadas pela CPU (uma instrução que
+//   causa erro, como falta de página, e é executada de novo conta uma vez)
+long cpu_num_instrucoes(cpu_t *self);
+
+// retorna o número de interrupções do tipo 'irq' aceitas pela CPU
+long cpu_num_irq(cpu_t *self, irq_t irq);
+
+// define o perfil onde serão contadas as instruções executadas (NULL para
+//   não contar)
+// sem perfil, a CPU executa uma versão do laço de execução que não tem
+//   nenhum custo de contagem
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil);
+
+// informa o nome do espaço de endereçamento da tabela de páginas 'tabpag'
+//   (o nome do programa) e seu mapa de símbolos (pode ser NULL), para o
+//   perfil; não faz nada se não tiver perfil
+void cpu_nomeia_tabpag(cpu_t *self, tabpag_t *tabpag, char *nome,
+                       simbolos_t *simbolos);
+
 // define a função a chamar quando executar a instrução CHAMAC
 // e o argumento a passar para ela (normalmente, um ponteiro para o SO)
 void cpu_define_chamaC(cpu_t *self, func_chamaC_t func, void *argC);
@@ -0,0 +1,76 @@
+// laço de execução de instruções da CPU
+// este arquivo não é um cabeçalho normal: é incluído duas vezes por cpu.c,
+//   para gerar duas versões das funções de execução, uma sem e outra com
+//   a contagem de instruções do perfil
+// antes de incluir, devem ser definidos:
+//   CPU_EXECUTA_1 - o nome da função que executa uma instrução
+//   CPU_EXECUTA_N - o nome da função que executa um lote de instruções
+//   CPU_COM_PERFIL - 1 para a versão que conta as instruções (e acompanha
+//                    as chamadas de rotina) no perfil, 0 para a outra
+// assim, a versão sem perfil não tem nenhum teste a mais por instrução; a
+//   escolha da versão é feita uma vez por lote (ver cpu_executa_n)
+
+static void CPU_EXECUTA_1(cpu_t *self)
+{
+  cpu__verifica_pic(self);
+  // não executa se CPU já estiver em erro
+  if (self->erro != ERR_OK) return;
+
+  predec_t *instr = cpu__busca_instrucao(self);
+  if (instr != NULL) {
+#if CPU_COM_PERFIL
+    tabpag_t *tabpag = mmu_tabpag(self->mmu);
+    cpu_modo_t modo = self->modo;
+    int opcode = instr->opcode;
+    int PC = self->PC;
+#endif
+    int A1 = instr->A1;
+    if (!instr->tem_A1 || instr->A1_na_cache || pega_A1(self, &A1)) {
+      instr->exec(self, A1);
+      // só conta instruções completadas: uma que causa erro (falta de
+      //   página, por exemplo) vai ser executada de novo, e é contada aí
+      if (self->erro == ERR_OK) {
+        self->n_instrucoes++;
+#if CPU_COM_PERFIL
+        perfil_conta(self->perfil, tabpag, modo, PC, opcode);
+        // a pilha de chamadas do perfil acompanha CHAMA e RET
+        if (opcode == CHAMA) {
+          perfil_chama(self->perfil, tabpag, modo, A1);
+        } else if (opcode == RET) {
+          perfil_retorna(self->perfil, tabpag, modo, A1);
+        }
+#endif
+      }
+    }
+  }
+
+  if (self->erro != ERR_OK && self->erro != ERR_CPU_PARADA && self->modo == usuario) {
+    cpu_interrompe(self, IRQ_ERR_CPU);
+  }
+}
+
+static int CPU_EXECUTA_N(cpu_t *self, int n, cpu_motivo_t *pmotivo)
+{
+  int executadas = 0;
+  self->interrompeu = false;
+  // uma CPU parada só volta a executar se aceitar uma interrupção; se
+  //   aceitar aqui, o lote termina depois da primeira instrução do
+  //   tratamento (o SO pode ter reprogramado os dispositivos)
+  cpu__verifica_pic(self);
+  while (executadas < n && self->erro == ERR_OK) {
+    CPU_EXECUTA_1(self);
+    executadas++;
+    if (self->interrompeu) {
+      *pmotivo = CPU_MOT_IRQ;
+      return executadas;
+    }
+  }
+  if (self->erro == ERR_OK) {
+    *pmotivo = CPU_MOT_LIMITE;
+  } else if (self->erro == ERR_CPU_PARADA) {
+    *pmotivo = CPU_MOT_PARADA;
+  } else {
+    *pmotivo = CPU_MOT_ERRO;
+  }
+  return executadas;
+}
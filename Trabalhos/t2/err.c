@@ -9,6 +9,7 @@ static char *nomes[N_ERR] = {
   [ERR_DISP_INV]   = "Dispositivo inválido",
   [ERR_OCUP]       = "Dispositivo ocupado",
   [ERR_INSTR_PRIV] = "Instrução privilegiada",
+  [ERR_SO]         = "Erro no SO",
 };
 
 // retorna o nome de erro
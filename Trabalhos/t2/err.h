@@ -12,6 +12,7 @@ typedef enum {
   ERR_OCUP,          // dispositivo ocupado
   ERR_INSTR_PRIV,    // instrução privilegiada
   ERR_PAG_AUSENTE,   // página de memória não mapeada
+  ERR_SO,            // o SO parou a CPU por um erro interno
   N_ERR              // número de erros
 } err_t;
 
@@ -0,0 +1,221 @@
+#include "log.h"
+#include "irq.h"
+#include "err.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// número de mensagens no buffer, potência de 2
+#define TAM_BUFFER 1024
+
+// tamanho máximo da string de uma mensagem (é truncada se for maior)
+#define TAM_STR 24
+
+// tamanho máximo do texto de uma mensagem
+#define TAM_LINHA 160
+
+// uma mensagem registrada
+typedef struct {
+  int tempo;
+  unsigned char nivel;
+  unsigned char cat;
+  unsigned short msg;
+  int arg[LOG_N_ARGS];
+  char str[TAM_STR];
+} log_registro_t;
+
+struct log_t {
+  relogio_t *relogio;
+  log_registro_t buffer[TAM_BUFFER];
+  // número de mensagens registradas desde o início; a mensagem n está na
+  //   posição n % TAM_BUFFER, se ainda não tiver sido sobrescrita
+  long n_registradas;
+  // número de mensagens já consideradas por log_mostra_novas
+  long n_vistas;
+  // o que é mostrado
+  int nivel;
+  bool categoria[N_LOG_CAT];
+};
+
+// formato de cada mensagem
+static char *formatos[N_LOG_MSG] = {
+  [LOG_MSG_IRQ]                  = "SO: recebi IRQ %d (%I)",
+  [LOG_MSG_IRQ_DESCONHECIDA]     = "SO: não sei tratar IRQ %d (%I)",
+  [LOG_MSG_ERR_CPU_SEM_PROC]     = "SO: erro na CPU sem processo corrente",
+  [LOG_MSG_CHAMADA]              = "SO: chamada de sistema %d",
+  [LOG_MSG_CHAMADA_SEM_PROC]     = "SO: chamada de sistema sem processo",
+  [LOG_MSG_CHAMADA_DESCONHECIDA] = "SO: chamada de sistema desconhecida (%d),"
+                                   " processo %d morto",
+  [LOG_MSG_SEM_PROCESSO]         = "SO: nenhum processo, fim",
+  [LOG_MSG_SEM_ENTRADA]          = "SO: processos esperando entrada que não"
+                                   " vai chegar, fim",
+  [LOG_MSG_ERRO_INIT]            = "SO: problema na carga do programa inicial",
+  [LOG_MSG_POUCOS_QUADROS]       = "SO: só %d quadros para os processos,"
+                                   " precisa de %d",
+  [LOG_MSG_PROC_CRIADO]          = "SO: processo %d criado ('%s')",
+  [LOG_MSG_PROC_MORREU]          = "SO: processo %d morreu (%d faltas de"
+                                   " página)",
+  [LOG_MSG_PROC_MORTO_POR_ERRO]  = "SO: processo %d morto por erro na CPU:"
+                                   " %E (%d) em %s",
+  [LOG_MSG_TABELA_CHEIA]         = "SO: tabela de processos cheia",
+  [LOG_MSG_ERRO_LEITURA_PROG]    = "Erro na leitura do programa '%s'",
+  [LOG_MSG_ERRO_CARGA]           = "Erro na carga da memória, end virt %d"
+                                   " fís %d",
+  [LOG_MSG_CARGA]                = "SO: carga de '%s' em V%d-%d, memória"
+                                   " secundária %d-%d",
+  [LOG_MSG_SEM_MEMORIA_SEC]      = "SO: não tem memória secundária para %d"
+                                   " páginas",
+  [LOG_MSG_FALTA_PAGINA]         = "SO: falta da página %d do processo %d,"
+                                   " colocada no quadro %d",
+};
+
+static char *nomes_nivel[] = { "erro", "aviso", "info", "traço" };
+static char *nomes_cat[N_LOG_CAT] = {
+  [LOG_SO]      = "so",
+  [LOG_IRQ]     = "irq",
+  [LOG_CHAMADA] = "chamada",
+  [LOG_PROC]    = "proc",
+  [LOG_MEM]     = "mem",
+};
+
+log_t *log_cria(relogio_t *relogio)
+{
+  log_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->relogio = relogio;
+  self->n_registradas = 0;
+  self->n_vistas = 0;
+  self->nivel = LOG_NIVEL_INFO;
+  for (int c = 0; c < N_LOG_CAT; c++) {
+    self->categoria[c] = true;
+  }
+  return self;
+}
+
+void log_destroi(log_t *self)
+{
+  free(self);
+}
+
+void log_define_nivel(log_t *self, int nivel)
+{
+  self->nivel = nivel;
+}
+
+void log_define_categoria(log_t *self, log_cat_t cat, bool mostra)
+{
+  self->categoria[cat] = mostra;
+}
+
+void log_registra(log_t *self, int nivel, log_cat_t cat, log_msg_t msg,
+                  char *str, int arg[LOG_N_ARGS])
+{
+  log_registro_t *reg = &self->buffer[self->n_registradas & (TAM_BUFFER - 1)];
+  self->n_registradas++;
+  reg->tempo = rel_agora(self->relogio);
+  reg->nivel = nivel;
+  reg->cat = cat;
+  reg->msg = msg;
+  memcpy(reg->arg, arg, sizeof(reg->arg));
+  if (str == NULL) {
+    reg->str[0] = '\0';
+  } else {
+    strncpy(reg->str, str, TAM_STR - 1);
+    reg->str[TAM_STR - 1] = '\0';
+  }
+}
+
+
+// montagem do texto
+
+// monta em 'linha' o texto da mensagem, conforme o formato dela
+static void log__formata(log_registro_t *reg, char linha[TAM_LINHA])
+{
+  char *f = formatos[reg->msg];
+  int pos = 0;
+  int i_arg = 0;
+  while (*f != '\0' && pos < TAM_LINHA - 1) {
+    if (*f != '%') {
+      linha[pos++] = *f++;
+      continue;
+    }
+    f++;
+    int resta = TAM_LINHA - pos;
+    int n;
+    // os argumentos que faltarem no registro são 0
+    int arg = (i_arg < LOG_N_ARGS) ? reg->arg[i_arg] : 0;
+    switch (*f) {
+      case 'd':
+        n = snprintf(&linha[pos], resta, "%d", arg);
+        i_arg++;
+        break;
+      case 'I':
+        n = snprintf(&linha[pos], resta, "%s", irq_nome(arg));
+        i_arg++;
+        break;
+      case 'E':
+        n = snprintf(&linha[pos], resta, "%s", err_nome(arg));
+        i_arg++;
+        break;
+      case 's':
+        n = snprintf(&linha[pos], resta, "%s", reg->str);
+        break;
+      default:
+        n = snprintf(&linha[pos], resta, "%c", *f);
+        break;
+    }
+    if (*f != '\0') f++;
+    pos += (n < resta) ? n : resta - 1;
+  }
+  linha[pos] = '\0';
+}
+
+static bool log__deve_mostrar(log_t *self, log_registro_t *reg)
+{
+  return reg->nivel <= self->nivel && self->categoria[reg->cat];
+}
+
+void log_mostra_novas(log_t *self, int max, log_f_saida_t saida, void *arg)
+{
+  // as que já foram sobrescritas estão perdidas
+  long ini = self->n_vistas;
+  if (ini < self->n_registradas - TAM_BUFFER) {
+    ini = self->n_registradas - TAM_BUFFER;
+  }
+  // procura, de trás para frente, a mais antiga das 'max' mais novas
+  if (max > 0) {
+    int n = 0;
+    long i;
+    for (i = self->n_registradas - 1; i >= ini; i--) {
+      if (log__deve_mostrar(self, &self->buffer[i & (TAM_BUFFER - 1)])) {
+        n++;
+        if (n == max) break;
+      }
+    }
+    if (i > ini) ini = i;
+  }
+  for (long i = ini; i < self->n_registradas; i++) {
+    log_registro_t *reg = &self->buffer[i & (TAM_BUFFER - 1)];
+    if (!log__deve_mostrar(self, reg)) continue;
+    char linha[TAM_LINHA];
+    log__formata(reg, linha);
+    saida(arg, linha);
+  }
+  self->n_vistas = self->n_registradas;
+}
+
+void log_despeja(log_t *self, FILE *arq)
+{
+  long ini = self->n_registradas - TAM_BUFFER;
+  if (ini < 0) ini = 0;
+  if (ini > 0) {
+    fprintf(arq, "(%ld mensagens mais antigas perdidas)\n", ini);
+  }
+  for (long i = ini; i < self->n_registradas; i++) {
+    log_registro_t *reg = &self->buffer[i & (TAM_BUFFER - 1)];
+    char linha[TAM_LINHA];
+    log__formata(reg, linha);
+    fprintf(arq, "%8d %-5s %-7s %s\n", reg->tempo, nomes_nivel[reg->nivel],
+            nomes_cat[reg->cat], linha);
+  }
+}
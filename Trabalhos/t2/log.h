@@ -0,0 +1,164 @@
+#ifndef LOG_H
+#define LOG_H
+
+// log
+// registro de mensagens do simulador (principalmente do SO)
+// registrar uma mensagem é barato: só é guardado, num buffer circular de
+//   tamanho fixo, o identificador do formato da mensagem e os argumentos
+//   (números, e no máximo uma string curta, que é copiada)
+// o texto só é montado quando a mensagem é mostrada (na console, pelo
+//   controlador) ou quando o buffer é despejado em um arquivo; quando o
+//   buffer enche, as mensagens mais antigas são perdidas
+// cada mensagem tem um nível de severidade e uma categoria (o subsistema
+//   que a gerou)
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "relogio.h"
+
+typedef struct log_t log_t;
+
+// níveis de severidade, do mais grave ao menos grave
+#define LOG_NIVEL_ERRO  0
+#define LOG_NIVEL_AVISO 1
+#define LOG_NIVEL_INFO  2
+#define LOG_NIVEL_TRACO 3
+
+// nível de compilação: as chamadas às macros de nível acima desse não
+//   geram código nenhum (por exemplo, compilando com -DLOG_NIVEL=2 o
+//   registro das interrupções e chamadas de sistema desaparece)
+#ifndef LOG_NIVEL
+#define LOG_NIVEL LOG_NIVEL_TRACO
+#endif
+
+// categorias
+typedef enum {
+  LOG_SO,            // geral do SO
+  LOG_IRQ,           // tratamento de interrupções
+  LOG_CHAMADA,       // chamadas de sistema
+  LOG_PROC,          // gerência de processos
+  LOG_MEM,           // gerência de memória, carga de programas
+  N_LOG_CAT
+} log_cat_t;
+
+// identificadores das mensagens; o formato de cada uma está em log.c
+// além de %d (int) e %s (a string do registro), os formatos podem ter
+//   %I (nome da interrupção com o número do argumento) e %E (nome do erro)
+typedef enum {
+  LOG_MSG_IRQ,
+  LOG_MSG_IRQ_DESCONHECIDA,
+  LOG_MSG_ERR_CPU_SEM_PROC,
+  LOG_MSG_CHAMADA,
+  LOG_MSG_CHAMADA_SEM_PROC,
+  LOG_MSG_CHAMADA_DESCONHECIDA,
+  LOG_MSG_SEM_PROCESSO,
+  LOG_MSG_SEM_ENTRADA,
+  LOG_MSG_ERRO_INIT,
+  LOG_MSG_POUCOS_QUADROS,
+  LOG_MSG_PROC_CRIADO,
+  LOG_MSG_PROC_MORREU,
+  LOG_MSG_PROC_MORTO_POR_ERRO,
+  LOG_MSG_TABELA_CHEIA,
+  LOG_MSG_ERRO_LEITURA_PROG,
+  LOG_MSG_ERRO_CARGA,
+  LOG_MSG_CARGA,
+  LOG_MSG_SEM_MEMORIA_SEC,
+  LOG_MSG_FALTA_PAGINA,
+  N_LOG_MSG
+} log_msg_t;
+
+// número máximo de argumentos numéricos de uma mensagem
+#define LOG_N_ARGS 4
+
+// cria o registro; o tempo de cada mensagem é obtido do relógio
+// só são mostradas (log_mostra_novas) as mensagens de nível até
+//   LOG_NIVEL_INFO, até ser alterado por log_define_nivel
+// retorna NULL em caso de erro
+log_t *log_cria(relogio_t *relogio);
+
+// destrói o registro
+void log_destroi(log_t *self);
+
+// define o nível máximo das mensagens mostradas
+void log_define_nivel(log_t *self, int nivel);
+
+// liga ou desliga a exibição das mensagens de uma categoria
+void log_define_categoria(log_t *self, log_cat_t cat, bool mostra);
+
+// registra uma mensagem; 'str' pode ser NULL
+// não deve ser chamada diretamente, usar as macros abaixo
+void log_registra(log_t *self, int nivel, log_cat_t cat, log_msg_t msg,
+                  char *str, int arg[LOG_N_ARGS]);
+
+// função chamada com o texto de cada mensagem mostrada
+typedef void (*log_f_saida_t)(void *arg, char *linha);
+
+// monta o texto das mensagens registradas desde a última chamada que
+//   devem ser mostradas (conforme nível e categoria), e chama 'saida' com
+//   cada uma, da mais antiga para a mais nova
+// se 'max' for maior que 0, só monta as 'max' mais recentes (as outras
+//   não seriam vistas mesmo)
+void log_mostra_novas(log_t *self, int max, log_f_saida_t saida, void *arg);
+
+// escreve em 'arq' todas as mensagens ainda no buffer, de todos os níveis
+//   e categorias, com o tempo, o nível e a categoria de cada uma
+void log_despeja(log_t *self, FILE *arq);
+
+
+// macros para o registro, uma para cada nível; as _STR têm uma string
+//   como argumento, antes dos números
+// os argumentos numéricos que faltarem são 0 (os números vão num vetor
+//   completado com zeros, o que não precisa de extensão do compilador
+//   para aceitar a lista de números vazia)
+#define LOG__PRIMEIRO(x, ...) x
+#define LOG__RESTO(x, ...) __VA_ARGS__
+// os argumentos variáveis são a mensagem seguida dos números
+#define LOG__REG(log, nivel, cat, ...) \
+  log_registra(log, nivel, cat, LOG__PRIMEIRO(__VA_ARGS__, 0), NULL, \
+               (int[]){ LOG__RESTO(__VA_ARGS__, 0, 0, 0, 0) })
+// os argumentos variáveis são a string seguida dos números
+#define LOG__REG_STR(log, nivel, cat, msg, ...) \
+  log_registra(log, nivel, cat, msg, LOG__PRIMEIRO(__VA_ARGS__, 0), \
+               (int[]){ LOG__RESTO(__VA_ARGS__, 0, 0, 0, 0) })
+
+#if LOG_NIVEL >= LOG_NIVEL_ERRO
+#define LOG_ERRO(log, cat, ...) \
+  LOG__REG(log, LOG_NIVEL_ERRO, cat, __VA_ARGS__)
+#define LOG_ERRO_STR(log, cat, msg, ...) \
+  LOG__REG_STR(log, LOG_NIVEL_ERRO, cat, msg, __VA_ARGS__)
+#else
+#define LOG_ERRO(log, cat, ...) ((void)0)
+#define LOG_ERRO_STR(log, cat, msg, ...) ((void)0)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_AVISO
+#define LOG_AVISO(log, cat, ...) \
+  LOG__REG(log, LOG_NIVEL_AVISO, cat, __VA_ARGS__)
+#define LOG_AVISO_STR(log, cat, msg, ...) \
+  LOG__REG_STR(log, LOG_NIVEL_AVISO, cat, msg, __VA_ARGS__)
+#else
+#define LOG_AVISO(log, cat, ...) ((void)0)
+#define LOG_AVISO_STR(log, cat, msg, ...) ((void)0)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_INFO
+#define LOG_INFO(log, cat, ...) \
+  LOG__REG(log, LOG_NIVEL_INFO, cat, __VA_ARGS__)
+#define LOG_INFO_STR(log, cat, msg, ...) \
+  LOG__REG_STR(log, LOG_NIVEL_INFO, cat, msg, __VA_ARGS__)
+#else
+#define LOG_INFO(log, cat, ...) ((void)0)
+#define LOG_INFO_STR(log, cat, msg, ...) ((void)0)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_TRACO
+#define LOG_TRACO(log, cat, ...) \
+  LOG__REG(log, LOG_NIVEL_TRACO, cat, __VA_ARGS__)
+#define LOG_TRACO_STR(log, cat, msg, ...) \
+  LOG__REG_STR(log, LOG_NIVEL_TRACO, cat, msg, __VA_ARGS__)
+#else
+#define LOG_TRACO(log, cat, ...) ((void)0)
+#define LOG_TRACO_STR(log, cat, msg, ...) ((void)0)
+#endif
+
+#endif // LOG_H
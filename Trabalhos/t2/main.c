@@ -4,35 +4,74 @@
 #include "mmu.h"
 #include "cpu.h"
 #include "relogio.h"
+#include "pic.h"
 #include "console.h"
 #include "so.h"
+#include "log.h"
+#include "perfil.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // constantes
-#define MEM_TAM 10000        // tamanho da memória principal
+#define MEM_TAM 10000        // tamanho padrão da memória principal (opção -m)
+#define MEM_SEC_TAM 100000   // tamanho da memória secundária
+#define TAU 10               // janela do wsclock, em ticks (opção -t)
+#define TAM_PAGINA 10        // tamanho padrão da página (opção -p)
+#define QUADROS_POR_SEGUNDO 30 // padrão de redesenhos da tela (opção -q)
+#define MAX_PONTOS_QUENTES 30  // endereços no relatório do perfil
+
+// configuração da execução, definida pela linha de comando
+typedef struct {
+  int tam_mem;
+  int tam_pagina;
+  int quadros_por_segundo;
+  int nivel_log;             // nível das mensagens mostradas (opção -l)
+  char *arq_log;             // onde despejar o log no final (opção -r)
+  char *arq_perfil;          // onde escrever o perfil no final (opção -P)
+  char *arq_pilhas;          // onde escrever as pilhas de chamada (opção -G)
+  long limite;               // instruções a executar, 0 sem limite (opção -n)
+  char *programa_inicial;    // programa do processo inicial (opção -i)
+  char *arq_estatisticas;    // onde escrever as estatísticas (opção -S)
+  subst_alg_t subst;         // algoritmo de substituição (opção -a)
+  int tau;                   // janela do conjunto de trabalho (opção -t)
+  tabpag_tipo_t tipo_tabpag; // organização das tabelas de páginas (-T)
+} config_t;
 
 
 typedef struct {
   mem_t *mem;
+  mem_t *mem_sec;
   mmu_t *mmu;
   cpu_t *cpu;
   relogio_t *relogio;
+  log_t *log;
+  pic_t *pic;
   console_t *console;
   es_t *es;
+  perfil_t *perfil;
   controle_t *controle;
 } hardware_t;
 
-void cria_hardware(hardware_t *hw)
+void cria_hardware(hardware_t *hw, config_t *cfg)
 {
-  // cria a memória e a MMU
-  hw->mem = mem_cria(MEM_TAM);
-  hw->mmu = mmu_cria(hw->mem);
+  // cria as memórias e a MMU
+  hw->mem = mem_cria(cfg->tam_mem);
+  hw->mem_sec = mem_cria(MEM_SEC_TAM);
+  hw->mmu = mmu_cria(hw->mem, cfg->tam_pagina);
+
+  // cria o controlador de interrupções
+  hw->pic = pic_cria();
 
   // cria dispositivos de E/S
-  hw->console = console_cria();
-  hw->relogio = rel_cria();
+  hw->console = console_cria(hw->pic);
+  console_define_quadros_por_segundo(hw->console, cfg->quadros_por_segundo);
+  hw->relogio = rel_cria(hw->pic);
+
+  // cria o registro de mensagens
+  hw->log = log_cria(hw->relogio);
+  log_define_nivel(hw->log, cfg->nivel_log);
 
   // cria o controlador de E/S e registra os dispositivos
   hw->es = es_cria();
@@ -49,41 +88,247 @@ void cria_hardware(hardware_t *hw)
   // lê relógio virtual, relógio real
   es_registra_dispositivo(hw->es, 8, hw->relogio, 0, rel_le, NULL);
   es_registra_dispositivo(hw->es, 9, hw->relogio, 1, rel_le, NULL);
+  // interrupções pendentes, habilitadas, a entregar
+  es_registra_dispositivo(hw->es, 20, hw->pic, 0, pic_le, NULL);
+  es_registra_dispositivo(hw->es, 21, hw->pic, 1, pic_le, pic_escr);
+  es_registra_dispositivo(hw->es, 22, hw->pic, 2, pic_le, NULL);
+
+  // cria a unidade de execução e inicializa com a MMU, E/S e controlador
+  //   de interrupções
+  hw->cpu = cpu_cria(hw->mmu, hw->es, hw->pic);
 
-  // cria a unidade de execução e inicializa com a MMU e E/S
-  hw->cpu = cpu_cria(hw->mmu, hw->es);
+  // cria o perfil de execução, se pedido
+  hw->perfil = NULL;
+  if (cfg->arq_perfil != NULL || cfg->arq_pilhas != NULL) {
+    hw->perfil = perfil_cria();
+    cpu_define_perfil(hw->cpu, hw->perfil);
+  }
 
   // cria o controlador e inicializa com a CPU
-  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio);
+  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio,
+                               hw->log);
+  controle_define_limite(hw->controle, cfg->limite);
 }
 
 void destroi_hardware(hardware_t *hw)
 {
   controle_destroi(hw->controle);
   cpu_destroi(hw->cpu);
+  if (hw->perfil != NULL) perfil_destroi(hw->perfil);
   es_destroi(hw->es);
+  log_destroi(hw->log);
   rel_destroi(hw->relogio);
+  pic_destroi(hw->pic);
   console_destroi(hw->console);
   mmu_destroi(hw->mmu);
+  mem_destroi(hw->mem_sec);
   mem_destroi(hw->mem);
 }
 
-int main()
+// escreve as estatísticas da execução em 'arq', uma por linha, no formato
+//   "nome=valor", para serem lidas por outros programas (ver alvo bench no
+//   Makefile)
+static void escreve_estatisticas(hardware_t *hw, so_t *so, FILE *arq)
+{
+  long instrucoes = cpu_num_instrucoes(hw->cpu);
+  double segundos = controle_tempo_real(hw->controle);
+  long n_irq = 0;
+  fprintf(arq, "instrucoes=%ld\n", instrucoes);
+  fprintf(arq, "relogio=%d\n", rel_agora(hw->relogio));
+  fprintf(arq, "tempo_ocioso=%ld\n", controle_tempo_ocioso(hw->controle));
+  fprintf(arq, "tempo_real_s=%.6f\n", segundos);
+  for (irq_t irq = 0; irq < N_IRQ; irq++) {
+    fprintf(arq, "irq_%d=%ld\n", irq, cpu_num_irq(hw->cpu, irq));
+    n_irq += cpu_num_irq(hw->cpu, irq);
+  }
+  long tlb_acertos, tlb_faltas;
+  mmu_tlb_contadores(hw->mmu, &tlb_acertos, &tlb_faltas);
+  fprintf(arq, "tlb_acertos=%ld\n", tlb_acertos);
+  fprintf(arq, "tlb_faltas=%ld\n", tlb_faltas);
+  fprintf(arq, "faltas_pagina=%ld\n", so_num_faltas_de_pagina(so));
+  if (segundos > 0) {
+    fprintf(arq, "mips=%.3f\n", instrucoes / segundos / 1e6);
+    fprintf(arq, "irq_por_s=%.0f\n", n_irq / segundos);
+  }
+  if (instrucoes > 0) {
+    fprintf(arq, "ns_por_instrucao=%.2f\n", segundos * 1e9 / instrucoes);
+  }
+}
+
+// lê um número inteiro de um argumento da linha de comando, não menor que
+//   'min'
+static int pega_num_arg(int argc, char *argv[argc], int argi, int min)
+{
+  if (argi >= argc) {
+    fprintf(stderr, "ERRO: falta valor após '%s'\n", argv[argi - 1]);
+    exit(1);
+  }
+  char *fim;
+  long val = strtol(argv[argi], &fim, 0);
+  if (*fim != '\0' || val < min) {
+    fprintf(stderr, "ERRO: valor inválido: '%s'\n", argv[argi]);
+    exit(1);
+  }
+  return val;
+}
+
+// pega um argumento da linha de comando que é um nome (de arquivo)
+static char *pega_str_arg(int argc, char *argv[argc], int argi)
+{
+  if (argi >= argc) {
+    fprintf(stderr, "ERRO: falta valor após '%s'\n", argv[argi - 1]);
+    exit(1);
+  }
+  return argv[argi];
+}
+
+static void verifica_args(int argc, char *argv[argc], config_t *cfg)
+{
+  cfg->tam_mem = MEM_TAM;
+  cfg->tam_pagina = TAM_PAGINA;
+  cfg->quadros_por_segundo = QUADROS_POR_SEGUNDO;
+  cfg->nivel_log = LOG_NIVEL_INFO;
+  cfg->arq_log = NULL;
+  cfg->arq_perfil = NULL;
+  cfg->arq_pilhas = NULL;
+  cfg->limite = 0;
+  cfg->programa_inicial = NULL;
+  cfg->arq_estatisticas = NULL;
+  cfg->subst = SUBST_FIFO;
+  cfg->tau = TAU;
+  cfg->tipo_tabpag = TABPAG_LINEAR;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-p") == 0) {
+      argi++;
+      cfg->tam_pagina = pega_num_arg(argc, argv, argi, 1);
+    } else if (strcmp(argv[argi], "-m") == 0) {
+      argi++;
+      cfg->tam_mem = pega_num_arg(argc, argv, argi, 100);
+    } else if (strcmp(argv[argi], "-a") == 0) {
+      argi++;
+      int alg = subst_alg_por_nome(pega_str_arg(argc, argv, argi));
+      if (alg < 0) {
+        fprintf(stderr, "ERRO: algoritmo de substituição desconhecido:"
+                        " '%s'; os algoritmos são:", argv[argi]);
+        for (alg = 0; alg < N_SUBST; alg++) {
+          fprintf(stderr, " %s", subst_nome(alg));
+        }
+        fprintf(stderr, "\n");
+        exit(1);
+      }
+      cfg->subst = alg;
+    } else if (strcmp(argv[argi], "-t") == 0) {
+      argi++;
+      cfg->tau = pega_num_arg(argc, argv, argi, 0);
+    } else if (strcmp(argv[argi], "-T") == 0) {
+      argi++;
+      int tipo = tabpag_tipo_por_nome(pega_str_arg(argc, argv, argi));
+      if (tipo < 0) {
+        fprintf(stderr, "ERRO: tipo de tabela de páginas desconhecido:"
+                        " '%s'; os tipos são:", argv[argi]);
+        for (tipo = 0; tipo < N_TABPAG_TIPO; tipo++) {
+          fprintf(stderr, " %s", tabpag_tipo_nome(tipo));
+        }
+        fprintf(stderr, "\n");
+        exit(1);
+      }
+      cfg->tipo_tabpag = tipo;
+    } else if (strcmp(argv[argi], "-q") == 0) {
+      argi++;
+      cfg->quadros_por_segundo = pega_num_arg(argc, argv, argi, 1);
+    } else if (strcmp(argv[argi], "-l") == 0) {
+      argi++;
+      cfg->nivel_log = pega_num_arg(argc, argv, argi, LOG_NIVEL_ERRO);
+    } else if (strcmp(argv[argi], "-r") == 0) {
+      argi++;
+      cfg->arq_log = pega_str_arg(argc, argv, argi);
+    } else if (strcmp(argv[argi], "-P") == 0) {
+      argi++;
+      cfg->arq_perfil = pega_str_arg(argc, argv, argi);
+    } else if (strcmp(argv[argi], "-G") == 0) {
+      argi++;
+      cfg->arq_pilhas = pega_str_arg(argc, argv, argi);
+    } else if (strcmp(argv[argi], "-n") == 0) {
+      argi++;
+      cfg->limite = pega_num_arg(argc, argv, argi, 1);
+    } else if (strcmp(argv[argi], "-i") == 0) {
+      argi++;
+      cfg->programa_inicial = pega_str_arg(argc, argv, argi);
+    } else if (strcmp(argv[argi], "-S") == 0) {
+      argi++;
+      cfg->arq_estatisticas = pega_str_arg(argc, argv, argi);
+    } else {
+      fprintf(stderr, "ERRO: chame como '%s [-m tam_memoria] "
+                      "[-p tam_pagina] [-a algoritmo_substituicao] "
+                      "[-t tau] [-T tipo_tabela_paginas] "
+                      "[-q quadros_por_segundo] [-l nivel_log] "
+                      "[-r arquivo_log] [-P arquivo_perfil] "
+                      "[-G arquivo_pilhas] [-n num_instrucoes] "
+                      "[-i programa_inicial] [-S arquivo_estatisticas]'\n",
+                      argv[0]);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char *argv[argc])
 {
   hardware_t hw;
   so_t *so;
+  config_t cfg;
+
+  verifica_args(argc, argv, &cfg);
 
   // cria o hardware
-  cria_hardware(&hw);
+  cria_hardware(&hw, &cfg);
   // cria o sistema operacional
-  so = so_cria(hw.cpu, hw.mem, hw.mmu, hw.console, hw.relogio);
+  so = so_cria(hw.cpu, hw.mem, hw.mem_sec, hw.mmu, hw.console, hw.relogio,
+               hw.log);
+  if (cfg.programa_inicial != NULL) {
+    so_define_programa_inicial(so, cfg.programa_inicial);
+  }
+  so_define_substituicao(so, cfg.subst, cfg.tau);
+  so_define_tipo_tabpag(so, cfg.tipo_tabpag);
   
   // executa o laço de execução da CPU
-  controle_laco(hw.controle);
+  int codigo = controle_laco(hw.controle);
+
+  // despeja o log, se pedido
+  if (cfg.arq_log != NULL) {
+    FILE *arq = fopen(cfg.arq_log, "w");
+    if (arq != NULL) {
+      log_despeja(hw.log, arq);
+      fclose(arq);
+    }
+  }
+  // escreve o relatório do perfil, se pedido
+  if (cfg.arq_perfil != NULL) {
+    FILE *arq = fopen(cfg.arq_perfil, "w");
+    if (arq != NULL) {
+      perfil_relatorio(hw.perfil, arq, MAX_PONTOS_QUENTES);
+      fclose(arq);
+    }
+  }
+  // escreve as estatísticas da execução, se pedido
+  if (cfg.arq_estatisticas != NULL) {
+    FILE *arq = fopen(cfg.arq_estatisticas, "w");
+    if (arq != NULL) {
+      escreve_estatisticas(&hw, so, arq);
+      fclose(arq);
+    }
+  }
+  // escreve as pilhas de chamada, se pedido (para gerar um flame graph)
+  if (cfg.arq_pilhas != NULL) {
+    FILE *arq = fopen(cfg.arq_pilhas, "w");
+    if (arq != NULL) {
+      perfil_escreve_pilhas(hw.perfil, arq);
+      fclose(arq);
+    }
+  }
 
   // destroi tudo
   so_destroi(so);
   destroi_hardware(&hw);
-  return 0;
+  return codigo;
 }
 
@@ -1,10 +1,14 @@
 #include "memoria.h"
 #include <stdlib.h>
+#include <string.h>
 
 // tipo de dados opaco para representar uma região de memória
 struct mem_t {
   int tam;
   int *conteudo;
+  // quem deve ser avisado quando o conteúdo é alterado
+  mem_f_alteracao_t f_alteracao;
+  void *arg_alteracao;
 };
 
 mem_t *mem_cria(int tam)
@@ -13,6 +17,8 @@ mem_t *mem_cria(int tam)
   self = malloc(sizeof(*self));
   if (self != NULL) {
     self->tam = tam;
+    self->f_alteracao = NULL;
+    self->arg_alteracao = NULL;
     self->conteudo = malloc(tam * sizeof(*(self->conteudo)));
     if (self->conteudo == NULL) {
       free(self);
@@ -60,6 +66,66 @@ err_t mem_escreve(mem_t *self, int endereco, int valor)
   err_t err = verif_permissao(self, endereco);
   if (err == ERR_OK) {
     self->conteudo[endereco] = valor;
+    if (self->f_alteracao != NULL) {
+      self->f_alteracao(self->arg_alteracao, endereco, 1);
+    }
+  }
+  return err;
+}
+
+// função auxiliar, verifica se todos os endereços de um bloco são válidos
+static err_t verif_bloco(mem_t *self, int endereco, int n)
+{
+  if (n < 0 || endereco < 0 || endereco > self->tam - n) {
+    return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+// avisa o observador da alteração de um bloco
+static void avisa_alteracao(mem_t *self, int endereco, int n)
+{
+  if (self->f_alteracao != NULL && n > 0) {
+    self->f_alteracao(self->arg_alteracao, endereco, n);
+  }
+}
+
+err_t mem_le_bloco(mem_t *self, int endereco, int n, int valores[n])
+{
+  err_t err = verif_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memcpy(valores, &self->conteudo[endereco], n * sizeof(int));
   }
   return err;
 }
+
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, int valores[n])
+{
+  err_t err = verif_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memcpy(&self->conteudo[endereco], valores, n * sizeof(int));
+    avisa_alteracao(self, endereco, n);
+  }
+  return err;
+}
+
+err_t mem_copia(mem_t *self, int endereco, mem_t *origem, int end_origem,
+                int n)
+{
+  err_t err = verif_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    err = verif_bloco(origem, end_origem, n);
+  }
+  if (err == ERR_OK) {
+    memmove(&self->conteudo[endereco], &origem->conteudo[end_origem],
+            n * sizeof(int));
+    avisa_alteracao(self, endereco, n);
+  }
+  return err;
+}
+
+void mem_define_obs_alteracao(mem_t *self, mem_f_alteracao_t f, void *arg)
+{
+  self->f_alteracao = f;
+  self->arg_alteracao = arg;
+}
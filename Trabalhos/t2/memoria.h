@@ -30,4 +30,37 @@ err_t mem_le(mem_t *self, int endereco, int *pvalor);
 // retorna erro ERR_END_INV se endereço inválido
 err_t mem_escreve(mem_t *self, int endereco, int valor);
 
+// operações em bloco
+// acessam 'n' posições consecutivas a partir de 'endereco', com uma só
+//   verificação de endereço e uma só cópia; servem para mover programas e
+//   páginas inteiras sem uma chamada por valor
+// retornam erro ERR_END_INV (e não acessam a memória) se alguma das
+//   posições for inválida
+
+// copia para o vetor 'valores' o conteúdo das 'n' posições da memória
+//   a partir de 'endereco'
+err_t mem_le_bloco(mem_t *self, int endereco, int n, int valores[n]);
+
+// copia o vetor 'valores' para as 'n' posições da memória a partir de
+//   'endereco'
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, int valores[n]);
+
+// copia 'n' posições da memória 'origem', a partir de 'end_origem', para
+//   a memória 'self', a partir de 'endereco'
+// as duas memórias podem ser a mesma, e as regiões podem ter sobreposição
+err_t mem_copia(mem_t *self, int endereco, mem_t *origem, int end_origem,
+                int n);
+
+// tipo da função chamada quando o conteúdo da memória é alterado
+// recebe o argumento fornecido no registro, o primeiro endereço alterado
+//   e o número de posições alteradas a partir dele
+typedef void (*mem_f_alteracao_t)(void *arg, int endereco, int n);
+
+// registra a função 'f' para ser chamada (com o argumento 'arg') depois de
+//   cada alteração no conteúdo da memória (uma vez para todo o bloco, nas
+//   operações em bloco) (usado pela CPU para manter
+//   coerente sua cache de instruções)
+// só uma função pode estar registrada; se 'f' for NULL, desfaz o registro
+void mem_define_obs_alteracao(mem_t *self, mem_f_alteracao_t f, void *arg);
+
 #endif // MEMORIA_H
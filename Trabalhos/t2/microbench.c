@@ -0,0 +1,377 @@
+// medição isolada das funções de acesso à memória
+//
+// executa mem_le, mmu_le, tabpag_traduz, tabpag_marca_bit_acesso e
+//   tabpag_colhe_bits muitas vezes, com acessos sequenciais, com passo
+//   (cada acesso numa página diferente) e aleatórios, para vários tamanhos
+//   de página e de tabela, e mostra o tempo médio de cada chamada, em ns
+// cada medida é uma linha com "nome=valor" separados por espaço:
+//   funcao=mmu_le padrao=seq tam_pagina=16 n_paginas=256 ns_por_op=3.21
+// para comparar duas versões (A/B), guarda-se a saída de uma delas e
+//   executa-se a outra com a opção -c, que acrescenta a cada linha o tempo
+//   da execução anterior (antes=) e a razão entre os dois (razao=, menor
+//   que 1 se ficou mais rápido)
+// as tabelas de páginas são lineares, ou do tipo escolhido com a opção -t
+//   (a comparação com -c serve também para comparar os tipos)
+//
+// uso: microbench [-n operacoes] [-r repeticoes] [-f funcao] [-t tipo_tabela]
+//                 [-c anterior]
+
+#include "memoria.h"
+#include "tabpag.h"
+#include "mmu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// número de endereços de cada padrão de acesso, potência de 2 (os acessos
+//   percorrem os endereços circularmente)
+#define TAM_SEQ 65536
+
+#define N_OPERACOES 1000000  // chamadas em cada medida (opção -n)
+#define REPETICOES 3         // medidas de cada caso, vale a menor (opção -r)
+#define MAX_ANTERIORES 1000  // linhas lidas da execução anterior (opção -c)
+
+static int tam_paginas[] = { 10, 16, 64, 256 };
+static int n_paginas[] = { 16, 256, 4096 };
+#define MAX_N_PAGINAS 4096
+#define N_TAM_PAGINAS (int)(sizeof(tam_paginas) / sizeof(tam_paginas[0]))
+#define N_N_PAGINAS (int)(sizeof(n_paginas) / sizeof(n_paginas[0]))
+
+typedef enum { SEQ, PASSO, ALEAT, N_PADRAO } padrao_t;
+static char *nomes_padrao[N_PADRAO] = { "seq", "passo", "aleat" };
+
+typedef enum {
+  F_MEM_LE, F_MMU_LE, F_TABPAG_TRADUZ, F_TABPAG_MARCA, F_TABPAG_COLHE,
+  N_FUNCAO
+} funcao_t;
+static char *nomes_funcao[N_FUNCAO] = {
+  "mem_le", "mmu_le", "tabpag_traduz", "tabpag_marca_bit_acesso",
+  "tabpag_colhe_bits"
+};
+
+// mapas de bits para tabpag_colhe_bits
+static uint64_t bits_acesso[MAX_N_PAGINAS / 64];
+static uint64_t bits_alteracao[MAX_N_PAGINAS / 64];
+
+// o que é medido em cada caso: uma memória com 'n_paginas' quadros, uma
+//   tabela que mapeia todas as páginas (em ordem embaralhada) e a MMU
+typedef struct {
+  int tam_pagina;
+  int n_paginas;
+  mem_t *mem;
+  tabpag_t *tabpag;
+  mmu_t *mmu;
+  int end[TAM_SEQ];     // endereços acessados
+  int pag[TAM_SEQ];     // as páginas desses endereços
+} caso_t;
+
+// uma linha de uma execução anterior, para comparação
+typedef struct {
+  char funcao[30];
+  char padrao[10];
+  int tam_pagina;
+  int n_paginas;
+  double ns_por_op;
+} anterior_t;
+
+// tipo das tabelas de páginas medidas (opção -t)
+static tabpag_tipo_t tipo_tabpag = TABPAG_LINEAR;
+
+// para o compilador não eliminar as chamadas cujo resultado não é usado
+static volatile unsigned resultado;
+
+// gerador de números pseudo-aleatórios, para ter a mesma sequência em
+//   todas as execuções (e em todas as versões comparadas)
+static unsigned semente;
+static int aleatorio(int max)
+{
+  semente = semente * 1103515245 + 12345;
+  return (semente >> 8) % max;
+}
+
+static double agora_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+
+// preparação dos casos
+
+static bool prepara_caso(caso_t *caso, int tam_pagina, int n_paginas)
+{
+  caso->tam_pagina = tam_pagina;
+  caso->n_paginas = n_paginas;
+  caso->mem = mem_cria(tam_pagina * n_paginas);
+  caso->tabpag = tabpag_cria(tipo_tabpag, tam_pagina, n_paginas);
+  caso->mmu = mmu_cria(caso->mem, tam_pagina);
+  if (caso->mem == NULL || caso->tabpag == NULL || caso->mmu == NULL) {
+    return false;
+  }
+  // quadros embaralhados, para a tradução não ser a identidade
+  int *quadros = malloc(n_paginas * sizeof(int));
+  if (quadros == NULL) return false;
+  for (int i = 0; i < n_paginas; i++) {
+    quadros[i] = i;
+  }
+  semente = 1;
+  for (int i = n_paginas - 1; i > 0; i--) {
+    int j = aleatorio(i + 1);
+    int t = quadros[i];
+    quadros[i] = quadros[j];
+    quadros[j] = t;
+  }
+  for (int pagina = 0; pagina < n_paginas; pagina++) {
+    tabpag_define_quadro(caso->tabpag, pagina, quadros[pagina]);
+  }
+  free(quadros);
+  for (int end = 0; end < tam_pagina * n_paginas; end++) {
+    mem_escreve(caso->mem, end, end);
+  }
+  mmu_define_tabpag(caso->mmu, caso->tabpag);
+  return true;
+}
+
+static void libera_caso(caso_t *caso)
+{
+  mmu_destroi(caso->mmu);
+  if (caso->tabpag != NULL) tabpag_destroi(caso->tabpag);
+  mem_destroi(caso->mem);
+}
+
+// preenche os endereços do caso conforme o padrão
+// sequencial: endereços consecutivos, começando em 0
+// passo: um endereço por página, sempre mais à frente (tam_pagina + 1), de
+//   forma que nenhum acesso é na mesma página do anterior
+// aleatório: qualquer endereço válido
+static void gera_enderecos(caso_t *caso, padrao_t padrao)
+{
+  int tam = caso->tam_pagina * caso->n_paginas;
+  semente = 2;
+  for (int i = 0; i < TAM_SEQ; i++) {
+    int end;
+    switch (padrao) {
+      case SEQ:
+        end = i % tam;
+        break;
+      case PASSO:
+        end = (int)(((long)i * (caso->tam_pagina + 1)) % tam);
+        break;
+      default:
+        end = aleatorio(tam);
+        break;
+    }
+    caso->end[i] = end;
+    caso->pag[i] = end / caso->tam_pagina;
+  }
+}
+
+
+// medidas
+
+// executa 'n' vezes a função, retorna o tempo médio por chamada, em ns
+static double mede(caso_t *caso, funcao_t funcao, long n)
+{
+  unsigned soma = 0;
+  int valor;
+  double ini = agora_ns();
+  switch (funcao) {
+    case F_MEM_LE:
+      for (long i = 0; i < n; i++) {
+        mem_le(caso->mem, caso->end[i & (TAM_SEQ - 1)], &valor);
+        soma += valor;
+      }
+      break;
+    case F_MMU_LE:
+      for (long i = 0; i < n; i++) {
+        mmu_le(caso->mmu, caso->end[i & (TAM_SEQ - 1)], &valor, usuario);
+        soma += valor;
+      }
+      break;
+    case F_TABPAG_TRADUZ:
+      for (long i = 0; i < n; i++) {
+        tabpag_traduz(caso->tabpag, caso->end[i & (TAM_SEQ - 1)], &valor);
+        soma += valor;
+      }
+      break;
+    case F_TABPAG_MARCA:
+      for (long i = 0; i < n; i++) {
+        tabpag_marca_bit_acesso(caso->tabpag, caso->pag[i & (TAM_SEQ - 1)],
+                                i & 1);
+      }
+      break;
+    case F_TABPAG_COLHE:
+      // como num tick de relógio do SO: uma página acessada desde a
+      //   colheita anterior, colhe os bits da tabela toda e zera os de acesso
+      for (long i = 0; i < n; i++) {
+        tabpag_marca_bit_acesso(caso->tabpag, caso->pag[i & (TAM_SEQ - 1)],
+                                i & 1);
+        tabpag_colhe_bits(caso->tabpag, bits_acesso, bits_alteracao, true);
+        soma += bits_acesso[0] & 1;
+      }
+      break;
+    default:
+      break;
+  }
+  double fim = agora_ns();
+  resultado = soma;
+  return (fim - ini) / n;
+}
+
+// a menor de 'repeticoes' medidas (a que sofreu menos interferência)
+static double melhor_medida(caso_t *caso, funcao_t funcao, long n,
+                            int repeticoes)
+{
+  double melhor = 0;
+  for (int r = 0; r < repeticoes; r++) {
+    double ns = mede(caso, funcao, n);
+    if (r == 0 || ns < melhor) melhor = ns;
+  }
+  return melhor;
+}
+
+
+// comparação com uma execução anterior
+
+static int le_anteriores(char *nome, anterior_t anteriores[MAX_ANTERIORES])
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) {
+    fprintf(stderr, "ERRO: não consegui abrir '%s'\n", nome);
+    exit(1);
+  }
+  int n = 0;
+  char linha[200];
+  while (n < MAX_ANTERIORES && fgets(linha, sizeof(linha), arq) != NULL) {
+    anterior_t *a = &anteriores[n];
+    if (sscanf(linha, "funcao=%29s padrao=%9s tam_pagina=%d n_paginas=%d"
+                      " ns_por_op=%lf", a->funcao, a->padrao,
+               &a->tam_pagina, &a->n_paginas, &a->ns_por_op) == 5) {
+      n++;
+    }
+  }
+  fclose(arq);
+  return n;
+}
+
+static anterior_t *busca_anterior(anterior_t *anteriores, int n_anteriores,
+                                  funcao_t funcao, padrao_t padrao,
+                                  int tam_pagina, int n_paginas)
+{
+  for (int i = 0; i < n_anteriores; i++) {
+    anterior_t *a = &anteriores[i];
+    if (strcmp(a->funcao, nomes_funcao[funcao]) == 0
+        && strcmp(a->padrao, nomes_padrao[padrao]) == 0
+        && a->tam_pagina == tam_pagina && a->n_paginas == n_paginas) {
+      return a;
+    }
+  }
+  return NULL;
+}
+
+
+// linha de comando
+
+static long pega_num_arg(int argc, char *argv[argc], int argi, int min)
+{
+  if (argi >= argc) {
+    fprintf(stderr, "ERRO: falta valor após '%s'\n", argv[argi - 1]);
+    exit(1);
+  }
+  char *fim;
+  long val = strtol(argv[argi], &fim, 0);
+  if (*fim != '\0' || val < min) {
+    fprintf(stderr, "ERRO: valor inválido: '%s'\n", argv[argi]);
+    exit(1);
+  }
+  return val;
+}
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s [-n operacoes] [-r repeticoes] [-f funcao]"
+                  " [-t tipo_tabela] [-c anterior]\n", nome);
+  fprintf(stderr, "  -n: chamadas em cada medida (%d)\n", N_OPERACOES);
+  fprintf(stderr, "  -r: medidas de cada caso, vale a menor (%d)\n",
+          REPETICOES);
+  fprintf(stderr, "  -f: mede só essa função (");
+  for (int f = 0; f < N_FUNCAO; f++) {
+    fprintf(stderr, "%s%s", f == 0 ? "" : ", ", nomes_funcao[f]);
+  }
+  fprintf(stderr, ")\n");
+  fprintf(stderr, "  -t: tipo das tabelas de páginas (");
+  for (int t = 0; t < N_TABPAG_TIPO; t++) {
+    fprintf(stderr, "%s%s", t == 0 ? "" : ", ", tabpag_tipo_nome(t));
+  }
+  fprintf(stderr, ")\n");
+  fprintf(stderr, "  -c: compara com a saída de uma execução anterior\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[argc])
+{
+  long n_operacoes = N_OPERACOES;
+  int repeticoes = REPETICOES;
+  int so_funcao = -1;
+  static anterior_t anteriores[MAX_ANTERIORES];
+  int n_anteriores = 0;
+  bool compara = false;
+
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-n") == 0) {
+      n_operacoes = pega_num_arg(argc, argv, ++argi, 1);
+    } else if (strcmp(argv[argi], "-r") == 0) {
+      repeticoes = pega_num_arg(argc, argv, ++argi, 1);
+    } else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc) {
+      argi++;
+      for (int f = 0; f < N_FUNCAO; f++) {
+        if (strcmp(argv[argi], nomes_funcao[f]) == 0) so_funcao = f;
+      }
+      if (so_funcao == -1) uso(argv[0]);
+    } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) {
+      int tipo = tabpag_tipo_por_nome(argv[++argi]);
+      if (tipo < 0) uso(argv[0]);
+      tipo_tabpag = tipo;
+    } else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc) {
+      n_anteriores = le_anteriores(argv[++argi], anteriores);
+      compara = true;
+    } else {
+      uso(argv[0]);
+    }
+  }
+
+  static caso_t caso;
+  for (int t = 0; t < N_TAM_PAGINAS; t++) {
+    for (int n = 0; n < N_N_PAGINAS; n++) {
+      if (!prepara_caso(&caso, tam_paginas[t], n_paginas[n])) {
+        fprintf(stderr, "ERRO: falta memória\n");
+        return 1;
+      }
+      for (padrao_t p = 0; p < N_PADRAO; p++) {
+        gera_enderecos(&caso, p);
+        for (funcao_t f = 0; f < N_FUNCAO; f++) {
+          if (so_funcao != -1 && f != so_funcao) continue;
+          double ns = melhor_medida(&caso, f, n_operacoes, repeticoes);
+          printf("funcao=%s padrao=%s tam_pagina=%d n_paginas=%d"
+                 " ns_por_op=%.2f", nomes_funcao[f], nomes_padrao[p],
+                 tam_paginas[t], n_paginas[n], ns);
+          if (compara) {
+            anterior_t *a = busca_anterior(anteriores, n_anteriores, f, p,
+                                           tam_paginas[t], n_paginas[n]);
+            if (a != NULL && a->ns_por_op > 0) {
+              printf(" antes=%.2f razao=%.3f", a->ns_por_op,
+                     ns / a->ns_por_op);
+            }
+          }
+          printf("\n");
+          fflush(stdout);
+        }
+      }
+      libera_caso(&caso);
+    }
+  }
+  return 0;
+}
@@ -1,19 +1,57 @@
 #include "mmu.h"
 #include <stdlib.h>
+#include <assert.h>
+
+// número de entradas da TLB (cache de traduções), potência de 2
+#define TAM_TLB 16
+
+// uma entrada da TLB: guarda a tradução de uma página e se os bits de
+//   acesso e alteração dessa página já foram marcados na tabela de páginas
+//   (para não ter que marcar de novo a cada acesso)
+typedef struct {
+  int pagina;       // página virtual, -1 se a entrada está vazia
+  int base;         // endereço físico do início do quadro
+  bool acessada;    // o bit de acesso já está marcado na tabela
+  bool alterada;    // o bit de alteração já está marcado na tabela
+} tlb_entrada_t;
 
 // tipo de dados opaco para representar uma MMU
 struct mmu_t {
   mem_t *mem;
   tabpag_t *tabpag;
+  // tamanho da página; se for potência de 2, bits_pagina é o log2 do
+  //   tamanho, senão é -1
+  int tam_pagina;
+  int bits_pagina;
+  // TLB, mapeamento direto (a página p fica na entrada p % TAM_TLB)
+  tlb_entrada_t tlb[TAM_TLB];
+  long tlb_acertos;
+  long tlb_faltas;
 };
 
-mmu_t *mmu_cria(mem_t *mem)
+// funções auxiliares
+static void mmu__esvazia_tlb(mmu_t *self);
+static void mmu__tabpag_alterada(void *arg, int pagina);
+
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina)
 {
+  if (tam_pagina < 1) return NULL;
   mmu_t *self;
   self = malloc(sizeof(*self));
   if (self != NULL) {
     self->mem = mem;
     self->tabpag = NULL;
+    self->tam_pagina = tam_pagina;
+    self->bits_pagina = -1;
+    if ((tam_pagina & (tam_pagina - 1)) == 0) {
+      self->bits_pagina = 0;
+      while ((1 << self->bits_pagina) < tam_pagina) {
+        self->bits_pagina++;
+      }
+    }
+    self->tlb_acertos = 0;
+    self->tlb_faltas = 0;
+    mmu__esvazia_tlb(self);
   }
   return self;
 }
@@ -21,13 +59,133 @@ mmu_t *mmu_cria(mem_t *mem)
 void mmu_destroi(mmu_t *self)
 {
   if (self != NULL) {
+    if (self->tabpag != NULL) {
+      tabpag_define_obs_alteracao(self->tabpag, NULL, NULL);
+    }
     free(self);
   }
 }
 
+int mmu_tam_pagina(mmu_t *self)
+{
+  return self->tam_pagina;
+}
+
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag)
 {
+  assert(tabpag == NULL || tabpag_tam_pagina(tabpag) == self->tam_pagina);
+  // a mesma tabela: as traduções na TLB continuam valendo
+  if (tabpag == self->tabpag) return;
+  if (self->tabpag != NULL) {
+    tabpag_define_obs_alteracao(self->tabpag, NULL, NULL);
+  }
   self->tabpag = tabpag;
+  if (self->tabpag != NULL) {
+    tabpag_define_obs_alteracao(self->tabpag, mmu__tabpag_alterada, self);
+  }
+  mmu__esvazia_tlb(self);
+}
+
+tabpag_t *mmu_tabpag(mmu_t *self)
+{
+  return self->tabpag;
+}
+
+mem_t *mmu_mem(mmu_t *self)
+{
+  return self->mem;
+}
+
+void mmu_tlb_contadores(mmu_t *self, long *pacertos, long *pfaltas)
+{
+  *pacertos = self->tlb_acertos;
+  *pfaltas = self->tlb_faltas;
+}
+
+
+// TLB
+
+static void mmu__esvazia_tlb(mmu_t *self)
+{
+  for (int i = 0; i < TAM_TLB; i++) {
+    self->tlb[i].pagina = -1;
+  }
+}
+
+// chamada pela tabela de páginas corrente quando a entrada de uma página é
+//   alterada; invalida a entrada da TLB correspondente, se houver
+static void mmu__tabpag_alterada(void *arg, int pagina)
+{
+  mmu_t *self = arg;
+  if (pagina < 0) return;
+  tlb_entrada_t *ent = &self->tlb[pagina & (TAM_TLB - 1)];
+  if (ent->pagina == pagina) {
+    ent->pagina = -1;
+  }
+}
+
+// traduz 'endvirt' usando a TLB; só consulta a tabela de páginas em caso
+//   de falta na TLB
+// retorna em '*pent' a entrada da TLB usada, para a marcação dos bits
+static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis,
+                         tlb_entrada_t **pent)
+{
+  if (endvirt < 0) return ERR_END_INV;
+  int pagina, deslocamento;
+  if (self->bits_pagina >= 0) {
+    pagina = endvirt >> self->bits_pagina;
+    deslocamento = endvirt & (self->tam_pagina - 1);
+  } else {
+    pagina = endvirt / self->tam_pagina;
+    deslocamento = endvirt % self->tam_pagina;
+  }
+  tlb_entrada_t *ent = &self->tlb[pagina & (TAM_TLB - 1)];
+  if (ent->pagina == pagina) {
+    self->tlb_acertos++;
+  } else {
+    self->tlb_faltas++;
+    int endfis;
+    err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
+    if (err != ERR_OK) return err;
+    ent->pagina = pagina;
+    ent->base = endfis - deslocamento;
+    ent->acessada = false;
+    ent->alterada = false;
+  }
+  *pendfis = ent->base + deslocamento;
+  *pent = ent;
+  return ERR_OK;
+}
+
+// marca os bits de acesso (e alteração) na tabela, se ainda não tiverem
+//   sido marcados desde que a entrada foi colocada na TLB
+static void mmu__marca_bits(mmu_t *self, tlb_entrada_t *ent, bool alteracao)
+{
+  if (!ent->acessada || (alteracao && !ent->alterada)) {
+    tabpag_marca_bit_acesso(self->tabpag, ent->pagina, alteracao);
+    ent->acessada = true;
+    if (alteracao) ent->alterada = true;
+  }
+}
+
+
+// acesso à memória
+
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo)
+{
+  if (modo == supervisor || self->tabpag == NULL) {
+    if (endvirt < 0 || endvirt >= mem_tam(self->mem)) return ERR_END_INV;
+    *pendfis = endvirt;
+    return ERR_OK;
+  }
+  int endfis;
+  tlb_entrada_t *ent;
+  err_t err = mmu__traduz(self, endvirt, &endfis, &ent);
+  if (err != ERR_OK) return err;
+  if (endfis < 0 || endfis >= mem_tam(self->mem)) return ERR_END_INV;
+  mmu__marca_bits(self, ent, false);
+  *pendfis = endfis;
+  return ERR_OK;
 }
 
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
@@ -36,11 +194,12 @@ err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
     return mem_le(self->mem, endvirt, pvalor);
   }
   int endfis;
-  err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
+  tlb_entrada_t *ent;
+  err_t err = mmu__traduz(self, endvirt, &endfis, &ent);
   if (err == ERR_OK) {
     err = mem_le(self->mem, endfis, pvalor);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
+      mmu__marca_bits(self, ent, false);
     }
   }
   return err;
@@ -52,12 +211,71 @@ err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
     return mem_escreve(self->mem, endvirt, valor);
   }
   int endfis;
-  err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
+  tlb_entrada_t *ent;
+  err_t err = mmu__traduz(self, endvirt, &endfis, &ent);
   if (err == ERR_OK) {
     err = mem_escreve(self->mem, endfis, valor);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
+      mmu__marca_bits(self, ent, true);
     }
   }
   return err;
 }
+
+err_t mmu_espia(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
+{
+  int endfis = endvirt;
+  if (modo == usuario && self->tabpag != NULL) {
+    if (endvirt < 0) return ERR_END_INV;
+    err_t err = tabpag_traduz(self->tabpag, endvirt, &endfis);
+    if (err != ERR_OK) return err;
+  }
+  return mem_le(self->mem, endfis, pvalor);
+}
+
+err_t mmu_traduz_faixa(mmu_t *self, tabpag_t *tabpag, int endvirt, int n,
+                       mmu_marca_t marca, mmu_f_trecho_t f, void *arg,
+                       int *pend_erro)
+{
+  if (tabpag == NULL) tabpag = self->tabpag;
+  int tam_mem = mem_tam(self->mem);
+  int fim = endvirt + n;
+  while (endvirt < fim) {
+    // o trecho vai até o fim da página ou da faixa
+    int n_trecho;
+    if (self->bits_pagina >= 0) {
+      n_trecho = self->tam_pagina - (endvirt & (self->tam_pagina - 1));
+    } else {
+      n_trecho = self->tam_pagina - endvirt % self->tam_pagina;
+    }
+    if (n_trecho > fim - endvirt) n_trecho = fim - endvirt;
+    int endfis = endvirt;
+    err_t err = ERR_OK;
+    if (endvirt < 0) {
+      err = ERR_END_INV;
+    } else if (tabpag != NULL) {
+      err = tabpag_traduz(tabpag, endvirt, &endfis);
+    } else {
+      // sem tradução, é um trecho só, até o fim da memória
+      n_trecho = fim - endvirt;
+      if (endvirt < tam_mem && n_trecho > tam_mem - endvirt) {
+        n_trecho = tam_mem - endvirt;
+      }
+    }
+    if (err == ERR_OK && (endfis < 0 || endfis > tam_mem - n_trecho)) {
+      err = ERR_END_INV;
+    }
+    if (err != ERR_OK) {
+      *pend_erro = endvirt;
+      return err;
+    }
+    if (tabpag != NULL && marca != MMU_NAO_MARCA) {
+      int pagina = (self->bits_pagina >= 0) ? endvirt >> self->bits_pagina
+                                             : endvirt / self->tam_pagina;
+      tabpag_marca_bit_acesso(tabpag, pagina, marca == MMU_MARCA_ALTERACAO);
+    }
+    if (!f(arg, endvirt, endfis, n_trecho)) break;
+    endvirt += n_trecho;
+  }
+  return ERR_OK;
+}
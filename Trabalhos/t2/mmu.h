@@ -5,6 +5,10 @@
 // realiza a tradução de endereços virtuais do espaço de endereçamento
 //   de um processo em endereços físicos da memória principal
 // implementa memória virtual por paginação
+// mantém uma pequena cache de traduções (TLB), que é esvaziada quando a
+//   tabela de páginas é trocada e tem a entrada de uma página invalidada
+//   quando essa página é alterada na tabela (tabpag_define_quadro ou
+//   tabpag_zera_bit_acesso)
 
 #include "tabpag.h"
 #include "memoria.h"
@@ -17,18 +21,80 @@ typedef struct mmu_t mmu_t;
 // cria uma MMU para gerenciar acessos à memória
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa MMU
-// recebe "mem", a memória física que será gerenciada
+// recebe "mem", a memória física que será gerenciada, e o tamanho das
+//   páginas (e quadros), em palavras
+// páginas de tamanho potência de 2 têm a tradução mais rápida
 // retorna NULL em caso de erro
-mmu_t *mmu_cria(mem_t *mem);
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina);
 
 // destrói uma MMU
 // nenhuma outra operação pode ser realizada na MMU após esta chamada
 void mmu_destroi(mmu_t *self);
 
+// retorna o tamanho das páginas, em palavras
+int mmu_tam_pagina(mmu_t *self);
+
 // define a tabela de páginas a usar nas próximas traduções
+// a tabela deve ter sido criada com o mesmo tamanho de página da MMU
 // se tabpag for NULL, os acessos serão repassados sem alteração à memória
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
 
+// retorna a tabela de páginas em uso (NULL se nenhuma)
+tabpag_t *mmu_tabpag(mmu_t *self);
+
+// coloca em '*pacertos' e '*pfaltas' o número de traduções que foram
+//   resolvidas pela TLB e o número das que precisaram consultar a tabela de
+//   páginas, desde a criação da MMU
+void mmu_tlb_contadores(mmu_t *self, long *pacertos, long *pfaltas);
+
+// retorna a memória física gerenciada pela MMU
+mem_t *mmu_mem(mmu_t *self);
+
+// traduz o endereço virtual 'endvirt' no endereço físico correspondente,
+//   colocado em '*pendfis', como seria feito em um acesso de leitura
+// marca a página como acessada se a tradução for bem sucedida
+// retorna erro se a tradução não for possível (ver tabpag_traduz) ou se o
+//   endereço físico resultante não existir na memória (ERR_END_INV)
+// em modo supervisor ou sem tabela de páginas, não há tradução (mas o
+//   endereço ainda é verificado)
+// usado pela CPU na busca de instruções, para acessar a memória física
+//   só quando não tiver a instrução decodificada em cache
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo);
+
+// tradução de faixas de endereços
+// para o SO acessar vários endereços consecutivos do espaço de um processo
+//   (uma string, um buffer) traduzindo cada página uma vez só
+
+// o que marcar na tabela de páginas, para cada página de uma faixa traduzida
+typedef enum {
+  MMU_NAO_MARCA,        // não altera os bits de acesso e alteração
+  MMU_MARCA_ACESSO,     // marca o bit de acesso
+  MMU_MARCA_ALTERACAO,  // marca os bits de acesso e alteração
+} mmu_marca_t;
+
+// tipo da função chamada para cada trecho de uma faixa traduzida
+// um trecho são 'n' endereços consecutivos da faixa, a partir do virtual
+//   'endvirt', que correspondem aos físicos a partir de 'endfis' (estão na
+//   mesma página)
+// retorna false para interromper a tradução do resto da faixa
+typedef bool (*mmu_f_trecho_t)(void *arg, int endvirt, int endfis, int n);
+
+// traduz a faixa de 'n' endereços virtuais a partir de 'endvirt', com a
+//   tabela de páginas 'tabpag' (ou a da MMU, se for NULL), chamando 'f'
+//   (com o argumento 'arg') para cada trecho, em ordem
+// cada página é traduzida uma vez, sem usar a TLB; os bits de cada página
+//   são marcados conforme 'marca'
+// sem tabela de páginas, a faixa é tratada como endereços físicos
+// retorna erro se a tradução de alguma página não for possível (ver
+//   tabpag_traduz) ou se algum endereço físico não existir na memória
+//   (ERR_END_INV); nesse caso, coloca em '*pend_erro' o primeiro endereço
+//   virtual que não pôde ser traduzido (os trechos anteriores a ele já
+//   foram passados para 'f')
+// a tradução interrompida por 'f' não é erro
+err_t mmu_traduz_faixa(mmu_t *self, tabpag_t *tabpag, int endvirt, int n,
+                       mmu_marca_t marca, mmu_f_trecho_t f, void *arg,
+                       int *pend_erro);
+
 // coloca na posição apontada por 'pvalor' o valor que está na memória
 //   no endereço físico correspondente ao endereço virtual 'endvirt'
 // marca a página como acessada se o acesso for bem sucedido
@@ -49,4 +115,10 @@ err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 //   à memória sem tradução
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo);
 
+// como mmu_le, mas sem efeito nenhum: não marca a página como acessada, não
+//   usa a TLB nem altera seus contadores
+// para quem só quer mostrar o conteúdo da memória (a descrição da CPU na
+//   console, por exemplo), sem interferir no que está sendo medido
+err_t mmu_espia(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
+
 #endif // MMU_H
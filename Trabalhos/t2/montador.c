@@ -41,6 +41,7 @@ int mem_min = -1;       // menor endereço preenchido
 int mem_max = -1;       // maior endereço preenchido
 
 char *nome_fonte;   // nome do arquivo fonte a montar
+char *nome_simbolos; // nome do arquivo para o mapa de símbolos (opção -s)
 
 // coloca um valor no final da memória
 void mem_insere(int val)
@@ -83,6 +84,7 @@ void mem_imprime(void)
 struct {
   char *nome;
   int valor;
+  bool endereco;          // é um label de posição de memória (não DEFINE)
 } simbolo[SIMB_TAM];
 int simb_num;             // número d símbolos na tabela
 
@@ -98,7 +100,8 @@ int simb_valor(char *nome)
 }
 
 // insere um novo símbolo na tabela
-void simb_novo(char *nome, int valor)
+// 'endereco' diz se o símbolo é um label de posição de memória
+void simb_novo(char *nome, int valor, bool endereco)
 {
   if (nome == NULL) return;
   if (simb_valor(nome) != -1) {
@@ -110,9 +113,40 @@ void simb_novo(char *nome, int valor)
   }
   simbolo[simb_num].nome = strdup(nome);
   simbolo[simb_num].valor = valor;
+  simbolo[simb_num].endereco = endereco;
   simb_num++;
 }
 
+int compara_simbolos(const void *a, const void *b)
+{
+  const int *ia = a;
+  const int *ib = b;
+  return simbolo[*ia].valor - simbolo[*ib].valor;
+}
+
+// escreve o mapa de símbolos: o nome e o endereço de cada label de posição
+//   de memória (os símbolos de DEFINE não são endereços), um por linha, em
+//   ordem de endereço
+// o simulador usa esse arquivo para mostrar endereços como "label+desl"
+void simb_imprime_mapa(char *nome)
+{
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) {
+    fprintf(stderr, "Não foi possível criar o arquivo '%s'\n", nome);
+    return;
+  }
+  int ordem[SIMB_TAM];
+  int n = 0;
+  for (int i = 0; i < simb_num; i++) {
+    if (simbolo[i].endereco) ordem[n++] = i;
+  }
+  qsort(ordem, n, sizeof(ordem[0]), compara_simbolos);
+  for (int i = 0; i < n; i++) {
+    fprintf(arq, "%s %d\n", simbolo[ordem[i]].nome, simbolo[ordem[i]].valor);
+  }
+  fclose(arq);
+}
+
 
 // referências
 
@@ -215,7 +249,7 @@ void monta_define(int linha, char *label, char *arg)
     fprintf(stderr, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
   } else {
     // tudo OK, define o símbolo
-    simb_novo(label, argn);
+    simb_novo(label, argn, false);
   }
 }
 
@@ -232,7 +266,7 @@ void monta_linha(int linha, char *label, char *instrucao, char *arg)
   
   // cria símbolo correspondente ao label, se for o caso
   if (label != NULL) {
-    simb_novo(label, mem_pos);
+    simb_novo(label, mem_pos, true);
   }
   
   // verifica a existência de instrução e número correto de argumentos
@@ -382,13 +416,20 @@ void verifica_args(int argc, char *argv[argc])
         fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
         exit(1);
       }
+    } else if (strcmp(argv[argi], "-s") == 0) {
+      argi++;
+      if (argi >= argc) {
+        fprintf(stderr, "ERRO: falta nome de arquivo após '-s'\n");
+        exit(1);
+      }
+      nome_simbolos = argv[argi];
     } else {
       nome_fonte = argv[argi];
     }
   }
   if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
-            argv[0]);
+    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] "
+                    "[-s arquivo_de_simbolos] nome_do_arquivo'\n", argv[0]);
     exit(1);
   }
 }
@@ -398,5 +439,8 @@ int main(int argc, char *argv[argc])
   verifica_args(argc, argv);
   monta_arquivo(nome_fonte);
   mem_imprime();
+  if (nome_simbolos != NULL) {
+    simb_imprime_mapa(nome_simbolos);
+  }
   return 0;
 }
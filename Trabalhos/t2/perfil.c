@@ -0,0 +1,469 @@
+#include "perfil.h"
+#include "instrucao.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// tamanho do nome de um espaço
+#define TAM_NOME 30
+
+// profundidade máxima da pilha de chamadas de um espaço; chamadas mais
+//   profundas são contadas na rotina chamadora
+#define MAX_PROFUNDIDADE 64
+
+// tamanho máximo de uma linha de pilha (para a saída de pilhas)
+#define TAM_PILHA ((MAX_PROFUNDIDADE + 1) * TAM_NOME)
+
+// um nó da árvore de chamadas: uma rotina, chamada a partir do caminho de
+//   rotinas desde a raiz (a pilha de chamadas)
+// os nós são identificados pelo índice no vetor de nós do perfil; um nó
+//   sempre tem índice maior que o do seu pai
+typedef struct {
+  int rotina;           // endereço da rotina (-1 na raiz de um espaço)
+  int espaco;
+  int pai;              // -1 na raiz
+  int primeiro_filho;
+  int prox_irmao;
+  int profundidade;
+  long n_exclusivo;     // instruções executadas com este nó no topo
+} no_t;
+
+// um espaço de endereçamento, com a contagem de instruções executadas em
+//   cada endereço (o vetor cresce conforme necessário)
+typedef struct {
+  tabpag_t *tabpag;     // tabela de páginas do espaço (NULL para o SO)
+  bool ativo;           // a tabela ainda é deste espaço
+  char nome[TAM_NOME];
+  simbolos_t *simbolos; // para mostrar os endereços pelo nome
+  long n_instrucoes;
+  long *n_pc;
+  int tam_n_pc;
+  // pilha de chamadas: a raiz da árvore do espaço e o nó do topo
+  int raiz;
+  int no_corrente;
+} espaco_t;
+
+struct perfil_t {
+  espaco_t *espacos;    // o espaço 0 é o do SO (modo supervisor)
+  int n_espacos;
+  int cap_espacos;
+  // último espaço usado em modo usuário (-1 se nenhum), para não procurar
+  //   a cada instrução
+  tabpag_t *tabpag_corrente;
+  int espaco_corrente;
+  long n_opcode[N_OPCODE + 1];  // o último é para opcode inválido
+  long n_modo[2];
+  // árvore de chamadas, de todos os espaços
+  no_t *nos;
+  int n_nos;
+  int cap_nos;
+};
+
+// funções auxiliares
+static int perfil__novo_espaco(perfil_t *self, tabpag_t *tabpag, char *nome,
+                               simbolos_t *simbolos);
+
+perfil_t *perfil_cria(void)
+{
+  perfil_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->espacos = NULL;
+  self->n_espacos = 0;
+  self->cap_espacos = 0;
+  self->tabpag_corrente = NULL;
+  self->espaco_corrente = -1;
+  for (int i = 0; i <= N_OPCODE; i++) {
+    self->n_opcode[i] = 0;
+  }
+  self->n_modo[supervisor] = 0;
+  self->n_modo[usuario] = 0;
+  self->nos = NULL;
+  self->n_nos = 0;
+  self->cap_nos = 0;
+  if (perfil__novo_espaco(self, NULL, "SO", NULL) != 0) {
+    free(self);
+    return NULL;
+  }
+  return self;
+}
+
+void perfil_destroi(perfil_t *self)
+{
+  for (int e = 0; e < self->n_espacos; e++) {
+    free(self->espacos[e].n_pc);
+  }
+  free(self->espacos);
+  free(self->nos);
+  free(self);
+}
+
+
+// espaços
+
+// cria um nó na árvore de chamadas, filho de 'pai' (ou raiz, se -1)
+// retorna o índice do nó, ou -1 em caso de erro
+static int perfil__novo_no(perfil_t *self, int espaco, int pai, int rotina)
+{
+  if (self->n_nos >= self->cap_nos) {
+    int cap = self->cap_nos == 0 ? 256 : self->cap_nos * 2;
+    no_t *novos = realloc(self->nos, cap * sizeof(*novos));
+    if (novos == NULL) return -1;
+    self->nos = novos;
+    self->cap_nos = cap;
+  }
+  int n = self->n_nos++;
+  no_t *no = &self->nos[n];
+  no->rotina = rotina;
+  no->espaco = espaco;
+  no->pai = pai;
+  no->primeiro_filho = -1;
+  no->prox_irmao = -1;
+  no->profundidade = 0;
+  no->n_exclusivo = 0;
+  if (pai >= 0) {
+    no->profundidade = self->nos[pai].profundidade + 1;
+    no->prox_irmao = self->nos[pai].primeiro_filho;
+    self->nos[pai].primeiro_filho = n;
+  }
+  return n;
+}
+
+// cria um espaço novo, retorna seu índice (-1 em caso de erro)
+static int perfil__novo_espaco(perfil_t *self, tabpag_t *tabpag, char *nome,
+                               simbolos_t *simbolos)
+{
+  if (self->n_espacos >= self->cap_espacos) {
+    int cap = self->cap_espacos == 0 ? 16 : self->cap_espacos * 2;
+    espaco_t *novos = realloc(self->espacos, cap * sizeof(*novos));
+    if (novos == NULL) return -1;
+    self->espacos = novos;
+    self->cap_espacos = cap;
+  }
+  int raiz = perfil__novo_no(self, self->n_espacos, -1, -1);
+  if (raiz < 0) return -1;
+  int e = self->n_espacos++;
+  espaco_t *esp = &self->espacos[e];
+  esp->tabpag = tabpag;
+  esp->ativo = true;
+  strncpy(esp->nome, nome, TAM_NOME - 1);
+  esp->nome[TAM_NOME - 1] = '\0';
+  esp->simbolos = simbolos;
+  esp->n_instrucoes = 0;
+  esp->n_pc = NULL;
+  esp->tam_n_pc = 0;
+  esp->raiz = raiz;
+  esp->no_corrente = raiz;
+  return e;
+}
+
+// retorna o índice do espaço ativo da tabela, criando um (sem nome) se não
+//   existir
+static int perfil__acha_espaco(perfil_t *self, tabpag_t *tabpag)
+{
+  for (int e = 1; e < self->n_espacos; e++) {
+    if (self->espacos[e].ativo && self->espacos[e].tabpag == tabpag) return e;
+  }
+  char nome[TAM_NOME];
+  sprintf(nome, "espaço%d", self->n_espacos);
+  return perfil__novo_espaco(self, tabpag, nome, NULL);
+}
+
+void perfil_nomeia_tabpag(perfil_t *self, tabpag_t *tabpag, char *nome,
+                          simbolos_t *simbolos)
+{
+  for (int e = 1; e < self->n_espacos; e++) {
+    if (self->espacos[e].tabpag == tabpag) self->espacos[e].ativo = false;
+  }
+  perfil__novo_espaco(self, tabpag, nome, simbolos);
+  self->espaco_corrente = -1;
+}
+
+
+// contagem
+
+// retorna o índice do espaço onde contar uma instrução executada no modo e
+//   com a tabela dados (-1 em caso de erro)
+static int perfil__espaco_de(perfil_t *self, tabpag_t *tabpag,
+                             cpu_modo_t modo)
+{
+  if (modo == supervisor) return 0;
+  if (self->espaco_corrente < 0 || tabpag != self->tabpag_corrente) {
+    self->espaco_corrente = perfil__acha_espaco(self, tabpag);
+    self->tabpag_corrente = tabpag;
+  }
+  return self->espaco_corrente;
+}
+
+void perfil_conta(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                  int pc, int opcode)
+{
+  self->n_modo[modo]++;
+  if (opcode < 0 || opcode >= N_OPCODE) opcode = N_OPCODE;
+  self->n_opcode[opcode]++;
+
+  int e = perfil__espaco_de(self, tabpag, modo);
+  if (e < 0) return;
+  espaco_t *esp = &self->espacos[e];
+  esp->n_instrucoes++;
+  self->nos[esp->no_corrente].n_exclusivo++;
+  if (pc < 0) return;
+  if (pc >= esp->tam_n_pc) {
+    int tam = esp->tam_n_pc == 0 ? 256 : esp->tam_n_pc;
+    while (tam <= pc) tam *= 2;
+    long *novo = realloc(esp->n_pc, tam * sizeof(*novo));
+    if (novo == NULL) return;
+    memset(&novo[esp->tam_n_pc], 0, (tam - esp->tam_n_pc) * sizeof(*novo));
+    esp->n_pc = novo;
+    esp->tam_n_pc = tam;
+  }
+  esp->n_pc[pc]++;
+}
+
+
+// pilha de chamadas
+
+void perfil_chama(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                  int rotina)
+{
+  int e = perfil__espaco_de(self, tabpag, modo);
+  if (e < 0) return;
+  espaco_t *esp = &self->espacos[e];
+  int pai = esp->no_corrente;
+  if (self->nos[pai].profundidade >= MAX_PROFUNDIDADE - 1) return;
+  // a rotina já foi chamada desse mesmo caminho?
+  int n = self->nos[pai].primeiro_filho;
+  while (n >= 0 && self->nos[n].rotina != rotina) {
+    n = self->nos[n].prox_irmao;
+  }
+  if (n < 0) {
+    n = perfil__novo_no(self, e, pai, rotina);
+    if (n < 0) return;
+  }
+  esp->no_corrente = n;
+}
+
+void perfil_retorna(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                    int rotina)
+{
+  int e = perfil__espaco_de(self, tabpag, modo);
+  if (e < 0) return;
+  espaco_t *esp = &self->espacos[e];
+  // desempilha até a rotina que está retornando; se ela não estiver na
+  //   pilha (desvio para fora de uma rotina, chamada além da profundidade
+  //   máxima), a pilha fica como está
+  int n = esp->no_corrente;
+  while (n != esp->raiz && self->nos[n].rotina != rotina) {
+    n = self->nos[n].pai;
+  }
+  if (n != esp->raiz) {
+    esp->no_corrente = self->nos[n].pai;
+  }
+}
+
+
+// relatório
+
+// um endereço de um espaço, com sua contagem, para ordenar
+typedef struct {
+  int espaco;
+  int pc;
+  long n;
+} ponto_t;
+
+static int compara_pontos(const void *a, const void *b)
+{
+  const ponto_t *pa = a;
+  const ponto_t *pb = b;
+  if (pa->n != pb->n) return pa->n < pb->n ? 1 : -1;
+  if (pa->espaco != pb->espaco) return pa->espaco - pb->espaco;
+  return pa->pc - pb->pc;
+}
+
+static double porcento(long n, long total)
+{
+  return total == 0 ? 0 : 100.0 * n / total;
+}
+
+// coloca em 'nome' o nome da rotina do nó (o do espaço, se for a raiz)
+static void perfil__nome_do_no(perfil_t *self, int n, char nome[TAM_NOME])
+{
+  no_t *no = &self->nos[n];
+  espaco_t *esp = &self->espacos[no->espaco];
+  if (no->pai < 0) {
+    strcpy(nome, esp->nome);
+  } else {
+    simb_descreve(esp->simbolos, no->rotina, TAM_NOME, nome);
+  }
+}
+
+// contagem de uma rotina de um espaço, para o relatório
+typedef struct {
+  int espaco;
+  int rotina;
+  int no;               // um dos nós da rotina, para o nome
+  long n_inclusivo;
+  long n_exclusivo;
+} rotina_t;
+
+static int compara_rotinas(const void *a, const void *b)
+{
+  const rotina_t *ra = a;
+  const rotina_t *rb = b;
+  if (ra->n_inclusivo != rb->n_inclusivo) {
+    return ra->n_inclusivo < rb->n_inclusivo ? 1 : -1;
+  }
+  if (ra->n_exclusivo != rb->n_exclusivo) {
+    return ra->n_exclusivo < rb->n_exclusivo ? 1 : -1;
+  }
+  return 0;
+}
+
+// escreve as 'max' rotinas com mais instruções executadas, contando as das
+//   rotinas chamadas por ela (inclusivo) e só as dela (exclusivo)
+static void perfil__relatorio_rotinas(perfil_t *self, FILE *arq, int max,
+                                      long total)
+{
+  // total da subárvore de cada nó; os filhos têm índice maior que o pai
+  long *n_arvore = malloc((self->n_nos + 1) * sizeof(*n_arvore));
+  rotina_t *rotinas = malloc((self->n_nos + 1) * sizeof(*rotinas));
+  if (n_arvore == NULL || rotinas == NULL) {
+    free(n_arvore);
+    free(rotinas);
+    return;
+  }
+  for (int n = 0; n < self->n_nos; n++) {
+    n_arvore[n] = self->nos[n].n_exclusivo;
+  }
+  for (int n = self->n_nos - 1; n >= 0; n--) {
+    if (self->nos[n].pai >= 0) n_arvore[self->nos[n].pai] += n_arvore[n];
+  }
+  int n_rotinas = 0;
+  for (int n = 0; n < self->n_nos; n++) {
+    no_t *no = &self->nos[n];
+    if (n_arvore[n] == 0) continue;
+    int r;
+    for (r = 0; r < n_rotinas; r++) {
+      if (rotinas[r].espaco == no->espaco && rotinas[r].rotina == no->rotina) {
+        break;
+      }
+    }
+    if (r == n_rotinas) {
+      rotinas[r] = (rotina_t){ no->espaco, no->rotina, n, 0, 0 };
+      n_rotinas++;
+    }
+    rotinas[r].n_exclusivo += no->n_exclusivo;
+    // numa chamada recursiva, a subárvore já foi contada no ancestral
+    int a = no->pai;
+    while (a >= 0 && self->nos[a].rotina != no->rotina) a = self->nos[a].pai;
+    if (a < 0) rotinas[r].n_inclusivo += n_arvore[n];
+  }
+  qsort(rotinas, n_rotinas, sizeof(rotinas[0]), compara_rotinas);
+  fprintf(arq, "por rotina:%*s inclusivo          exclusivo\n", 30, "");
+  for (int r = 0; r < n_rotinas && r < max; r++) {
+    // a raiz é o código fora de rotinas, identificada só pelo espaço
+    char onde[2 * TAM_NOME + 2];
+    strcpy(onde, self->espacos[rotinas[r].espaco].nome);
+    if (rotinas[r].rotina >= 0) {
+      char nome[TAM_NOME];
+      perfil__nome_do_no(self, rotinas[r].no, nome);
+      strcat(onde, ":");
+      strcat(onde, nome);
+    }
+    fprintf(arq, "  %-40s %10ld %5.1f%% %10ld %5.1f%%\n", onde,
+            rotinas[r].n_inclusivo, porcento(rotinas[r].n_inclusivo, total),
+            rotinas[r].n_exclusivo, porcento(rotinas[r].n_exclusivo, total));
+  }
+  free(n_arvore);
+  free(rotinas);
+}
+
+void perfil_relatorio(perfil_t *self, FILE *arq, int max_pc)
+{
+  long total = self->n_modo[usuario] + self->n_modo[supervisor];
+  fprintf(arq, "PERFIL DE EXECUÇÃO\n");
+  fprintf(arq, "instruções: %ld\n", total);
+  fprintf(arq, "  modo usuário:    %10ld %5.1f%%\n", self->n_modo[usuario],
+          porcento(self->n_modo[usuario], total));
+  fprintf(arq, "  modo supervisor: %10ld %5.1f%%\n", self->n_modo[supervisor],
+          porcento(self->n_modo[supervisor], total));
+
+  // opcodes, em ordem decrescente
+  ponto_t ops[N_OPCODE + 1];
+  int n_ops = 0;
+  for (int op = 0; op <= N_OPCODE; op++) {
+    if (self->n_opcode[op] == 0) continue;
+    ops[n_ops++] = (ponto_t){ 0, op, self->n_opcode[op] };
+  }
+  qsort(ops, n_ops, sizeof(ops[0]), compara_pontos);
+  fprintf(arq, "por opcode:\n");
+  for (int i = 0; i < n_ops; i++) {
+    char *nome = ops[i].pc == N_OPCODE ? "inválido" : instrucao_nome(ops[i].pc);
+    fprintf(arq, "  %-8s %10ld %5.1f%%\n", nome, ops[i].n,
+            porcento(ops[i].n, total));
+  }
+
+  // espaços, na ordem de criação
+  fprintf(arq, "por espaço de endereçamento:\n");
+  for (int e = 0; e < self->n_espacos; e++) {
+    espaco_t *esp = &self->espacos[e];
+    if (esp->n_instrucoes == 0) continue;
+    fprintf(arq, "  %-20s %10ld %5.1f%%\n", esp->nome, esp->n_instrucoes,
+            porcento(esp->n_instrucoes, total));
+  }
+
+  // endereços mais executados
+  int n_pontos = 0;
+  for (int e = 0; e < self->n_espacos; e++) {
+    espaco_t *esp = &self->espacos[e];
+    for (int pc = 0; pc < esp->tam_n_pc; pc++) {
+      if (esp->n_pc[pc] > 0) n_pontos++;
+    }
+  }
+  ponto_t *pontos = malloc((n_pontos + 1) * sizeof(*pontos));
+  if (pontos == NULL) return;
+  int p = 0;
+  for (int e = 0; e < self->n_espacos; e++) {
+    espaco_t *esp = &self->espacos[e];
+    for (int pc = 0; pc < esp->tam_n_pc; pc++) {
+      if (esp->n_pc[pc] > 0) pontos[p++] = (ponto_t){ e, pc, esp->n_pc[pc] };
+    }
+  }
+  qsort(pontos, n_pontos, sizeof(pontos[0]), compara_pontos);
+  fprintf(arq, "pontos quentes:\n");
+  for (int i = 0; i < n_pontos && i < max_pc; i++) {
+    espaco_t *esp = &self->espacos[pontos[i].espaco];
+    char onde[2 * TAM_NOME + 20];
+    if (esp->simbolos == NULL) {
+      sprintf(onde, "%s:%d", esp->nome, pontos[i].pc);
+    } else {
+      char end[TAM_NOME];
+      simb_descreve(esp->simbolos, pontos[i].pc, TAM_NOME, end);
+      sprintf(onde, "%s:%s (%d)", esp->nome, end, pontos[i].pc);
+    }
+    fprintf(arq, "  %-40s %10ld %5.1f%%\n", onde, pontos[i].n,
+            porcento(pontos[i].n, total));
+  }
+  free(pontos);
+
+  perfil__relatorio_rotinas(self, arq, max_pc, total);
+}
+
+void perfil_escreve_pilhas(perfil_t *self, FILE *arq)
+{
+  for (int n = 0; n < self->n_nos; n++) {
+    if (self->nos[n].n_exclusivo == 0) continue;
+    // monta a pilha do fim para o início, subindo até a raiz
+    char pilha[TAM_PILHA];
+    int pos = TAM_PILHA - 1;
+    pilha[pos] = '\0';
+    for (int a = n; a >= 0; a = self->nos[a].pai) {
+      char nome[TAM_NOME];
+      perfil__nome_do_no(self, a, nome);
+      int tam = strlen(nome);
+      if (a != n) pilha[--pos] = ';';
+      pos -= tam;
+      memcpy(&pilha[pos], nome, tam);
+    }
+    fprintf(arq, "%s %ld\n", &pilha[pos], self->nos[n].n_exclusivo);
+  }
+}
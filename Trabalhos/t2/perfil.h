@@ -0,0 +1,72 @@
+#ifndef PERFIL_H
+#define PERFIL_H
+
+// perfil
+// contagem das instruções executadas pela CPU, para descobrir onde os
+//   programas passam o tempo
+// conta o número de instruções executadas de cada opcode, em cada modo
+//   da CPU, e em cada posição de cada espaço de endereçamento
+// um espaço de endereçamento é identificado pela tabela de páginas em uso
+//   na MMU quando a instrução é executada em modo usuário (o SO pode dar
+//   um nome a ele, em geral o nome do programa); as instruções executadas
+//   em modo supervisor são contadas no espaço "SO", por endereço físico
+// a CPU só conta as instruções se tiver um perfil definido (ver
+//   cpu_define_perfil)
+
+#include <stdio.h>
+#include "tabpag.h"
+#include "cpu_modo.h"
+#include "simbolos.h"
+
+typedef struct perfil_t perfil_t;
+
+// cria um perfil, com todas as contagens zeradas
+// retorna NULL em caso de erro
+perfil_t *perfil_cria(void);
+
+// destrói o perfil
+void perfil_destroi(perfil_t *self);
+
+// dá um nome ao espaço de endereçamento da tabela de páginas 'tabpag'
+// a partir daqui, as instruções executadas com essa tabela são contadas
+//   num espaço novo, mesmo que essa tabela (esse endereço de memória) já
+//   tenha sido usada antes (por um processo que morreu, por exemplo)
+// se 'simbolos' não for NULL, os endereços desse espaço são mostrados no
+//   relatório pelo nome; o mapa deve existir até o relatório ser gerado
+void perfil_nomeia_tabpag(perfil_t *self, tabpag_t *tabpag, char *nome,
+                          simbolos_t *simbolos);
+
+// conta uma instrução completada (sem erro), de opcode 'opcode',
+//   executada no endereço 'pc', no modo 'modo', com a tabela de páginas
+//   'tabpag'
+void perfil_conta(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                  int pc, int opcode);
+
+// pilha de chamadas
+// a CPU informa as instruções CHAMA e RET executadas, e o perfil mantém
+//   uma pilha de chamadas para cada espaço de endereçamento (cada processo);
+//   as rotinas são identificadas pelo endereço (o argumento de CHAMA e RET,
+//   onde fica o endereço de retorno, que é o label da rotina)
+// cada instrução contada é atribuída à pilha corrente do seu espaço
+
+// informa que foi executada uma chamada (CHAMA) para 'rotina'
+void perfil_chama(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                  int rotina);
+
+// informa que foi executado um retorno (RET) de 'rotina'
+void perfil_retorna(perfil_t *self, tabpag_t *tabpag, cpu_modo_t modo,
+                    int rotina);
+
+// escreve em 'arq' o número de instruções executadas em cada pilha de
+//   chamadas, no formato "espaço;rotina;rotina número" (uma linha por
+//   pilha, com as rotinas da mais externa para a mais interna), que é o
+//   formato das ferramentas de flame graph (flamegraph.pl, por exemplo)
+void perfil_escreve_pilhas(perfil_t *self, FILE *arq);
+
+// escreve em 'arq' o relatório do perfil: total por modo, instruções por
+//   opcode e por espaço, e os 'max_pc' endereços e rotinas mais
+//   executados, em ordem decrescente de número de instruções (as rotinas
+//   com a contagem inclusiva, que inclui as rotinas chamadas, e exclusiva)
+void perfil_relatorio(perfil_t *self, FILE *arq, int max_pc);
+
+#endif // PERFIL_H
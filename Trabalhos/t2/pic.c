@@ -0,0 +1,109 @@
+#include "pic.h"
+#include <stdlib.h>
+
+// as interrupções de dispositivo, da mais para a menos prioritária
+static irq_t prioridade[] = { IRQ_RELOGIO, IRQ_TECLADO, IRQ_TELA };
+#define N_PRIO (sizeof(prioridade) / sizeof(prioridade[0]))
+
+struct pic_t {
+  unsigned pendentes;    // bit n ligado se a irq n está sendo pedida
+  unsigned habilitadas;  // bit n ligado se a irq n pode ser entregue
+  unsigned ativas;       // pendentes & habilitadas
+  // quem avisar quando ativas passar a ser ou deixar de ser 0
+  pic_f_aviso_t f_aviso;
+  void *arg_aviso;
+};
+
+// recalcula as interrupções ativas, avisando se mudou ter ou não alguma
+static void pic__atualiza_ativas(pic_t *self)
+{
+  bool tinha = self->ativas != 0;
+  self->ativas = self->pendentes & self->habilitadas;
+  bool tem = self->ativas != 0;
+  if (tem != tinha && self->f_aviso != NULL) {
+    self->f_aviso(self->arg_aviso, tem);
+  }
+}
+
+pic_t *pic_cria(void)
+{
+  pic_t *self = malloc(sizeof(*self));
+  if (self != NULL) {
+    self->pendentes = 0;
+    self->habilitadas = ~0u;
+    self->ativas = 0;
+    self->f_aviso = NULL;
+    self->arg_aviso = NULL;
+  }
+  return self;
+}
+
+void pic_destroi(pic_t *self)
+{
+  free(self);
+}
+
+void pic_sinaliza(pic_t *self, irq_t irq, bool ativa)
+{
+  if (irq < 0 || irq >= N_IRQ) return;
+  if (ativa) {
+    self->pendentes |= 1u << irq;
+  } else {
+    self->pendentes &= ~(1u << irq);
+  }
+  pic__atualiza_ativas(self);
+}
+
+bool pic_tem_irq(pic_t *self)
+{
+  return self->ativas != 0;
+}
+
+void pic_define_obs_irq(pic_t *self, pic_f_aviso_t f, void *arg)
+{
+  self->f_aviso = f;
+  self->arg_aviso = arg;
+  if (f != NULL) f(arg, self->ativas != 0);
+}
+
+irq_t pic_irq(pic_t *self)
+{
+  if (self->ativas == 0) return N_IRQ;
+  for (int i = 0; i < N_PRIO; i++) {
+    if (self->ativas & (1u << prioridade[i])) return prioridade[i];
+  }
+  return N_IRQ;
+}
+
+err_t pic_le(void *disp, int id, int *pvalor)
+{
+  pic_t *self = disp;
+  switch (id) {
+    case 0:
+      *pvalor = self->pendentes;
+      break;
+    case 1:
+      *pvalor = self->habilitadas;
+      break;
+    case 2:
+      *pvalor = pic_irq(self);
+      break;
+    default:
+      return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+err_t pic_escr(void *disp, int id, int valor)
+{
+  pic_t *self = disp;
+  switch (id) {
+    case 1:
+      self->habilitadas = valor;
+      pic__atualiza_ativas(self);
+      break;
+    default:
+      return ERR_END_INV;
+  }
+  return ERR_OK;
+}
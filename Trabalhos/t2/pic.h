@@ -0,0 +1,57 @@
+#ifndef PIC_H
+#define PIC_H
+
+// simulador do controlador de interrupções (PIC)
+// os dispositivos sinalizam que querem interromper a CPU ligando o bit
+//   correspondente à sua interrupção na máscara de pendentes, e desligam
+//   quando o pedido é atendido (em geral pelo SO, no dispositivo)
+// cada interrupção pode ser habilitada ou não (máscara de habilitadas);
+//   só as pendentes e habilitadas são entregues à CPU
+// quando tem mais de uma, a CPU recebe a de maior prioridade; as
+//   prioridades são fixas: relógio, teclado, tela
+
+#include <stdbool.h>
+#include "err.h"
+#include "irq.h"
+
+typedef struct pic_t pic_t;
+
+// cria e inicializa um controlador de interrupções, sem interrupções
+//   pendentes e com todas habilitadas
+// retorna NULL em caso de erro
+pic_t *pic_cria(void);
+
+// destrói o controlador
+void pic_destroi(pic_t *self);
+
+// chamada por um dispositivo para ligar (ativa true) ou desligar (ativa
+//   false) seu pedido de interrupção
+void pic_sinaliza(pic_t *self, irq_t irq, bool ativa);
+
+// retorna true se tem alguma interrupção pendente e habilitada
+bool pic_tem_irq(pic_t *self);
+
+// retorna a interrupção pendente e habilitada de maior prioridade, ou
+//   N_IRQ se não tiver nenhuma
+irq_t pic_irq(pic_t *self);
+
+// tipo da função chamada quando muda o resultado de pic_tem_irq
+// recebe o argumento fornecido no registro e o novo resultado
+typedef void (*pic_f_aviso_t)(void *arg, bool tem_irq);
+
+// registra a função 'f' para ser chamada (com o argumento 'arg') quando o
+//   controlador passar a ter interrupção para entregar ou deixar de ter;
+//   'f' é chamada também no registro, com a situação atual
+// usado pela CPU, para verificar a cada instrução uma variável própria em
+//   vez de chamar pic_tem_irq
+// só uma função pode estar registrada; se 'f' for NULL, desfaz o registro
+void pic_define_obs_irq(pic_t *self, pic_f_aviso_t f, void *arg);
+
+// Funções para acessar o controlador como um dispositivo de E/S
+//   '0' para ler a máscara de interrupções pendentes (bit n para irq n)
+//   '1' para ler ou escrever a máscara de interrupções habilitadas
+//   '2' para ler a interrupção que seria entregue à CPU (ou N_IRQ)
+err_t pic_le(void *disp, int id, int *pvalor);
+err_t pic_escr(void *disp, int id, int valor);
+
+#endif // PIC_H
@@ -89,3 +89,8 @@ int prog_dado(programa_t *self, int ender)
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
   return self->dados[ender - self->carga];
 }
+
+int *prog_dados(programa_t *self)
+{
+  return self->dados;
+}
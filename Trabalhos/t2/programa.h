@@ -26,4 +26,8 @@ int prog_end_inicio(programa_t *self);
 // valor a colocar na posição 'ender' da memória
 int prog_dado(programa_t *self, int ender);
 
+// vetor com os prog_tamanho() valores do programa, o primeiro é o que vai
+//   no endereço prog_end_carga() (para a carga em bloco na memória)
+int *prog_dados(programa_t *self);
+
 #endif // PROGRAMA_H
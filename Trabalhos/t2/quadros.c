@@ -0,0 +1,178 @@
+#include "quadros.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// o que está em um quadro
+// um quadro livre está na lista de livres, um ocupado na lista do dono;
+//   as duas usam os campos prox e ant (a de livres só prox)
+typedef struct {
+  int pid;            // dono, 0 se livre ou fixo
+  tabpag_t *tabpag;   // tabela de páginas do dono
+  int pagina;         // página do dono que está no quadro
+  bool fixo;
+  bool em_transferencia;
+  int prox;
+  int ant;
+  quadros_lista_t *lista;  // lista do dono
+} quadro_t;
+
+struct quadros_t {
+  quadro_t *quadros;
+  int n_quadros;
+  // lista de quadros livres, -1 se vazia
+  int livre;
+  int n_livres;
+  int n_em_transferencia;
+};
+
+// registra o quadro como livre, no início da lista de livres
+static void quadros__poe_na_lista_livre(quadros_t *self, int quadro)
+{
+  quadro_t *q = &self->quadros[quadro];
+  q->pid = 0;
+  q->tabpag = NULL;
+  q->pagina = -1;
+  q->em_transferencia = false;
+  q->lista = NULL;
+  q->ant = -1;
+  q->prox = self->livre;
+  self->livre = quadro;
+  self->n_livres++;
+}
+
+quadros_t *quadros_cria(int n_quadros, int n_fixos)
+{
+  quadros_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->quadros = malloc(n_quadros * sizeof(quadro_t));
+  if (self->quadros == NULL) {
+    free(self);
+    return NULL;
+  }
+  self->n_quadros = n_quadros;
+  self->livre = -1;
+  self->n_livres = 0;
+  self->n_em_transferencia = 0;
+  // os livres são colocados do último para o primeiro, para serem
+  //   alocados em ordem crescente
+  for (int q = n_quadros - 1; q >= 0; q--) {
+    self->quadros[q].fixo = q < n_fixos;
+    quadros__poe_na_lista_livre(self, q);
+  }
+  // os fixos não ficam na lista de livres; como são os primeiros, estão
+  //   todos no início da lista
+  for (int q = 0; q < n_fixos && q < n_quadros; q++) {
+    self->livre = self->quadros[q].prox;
+    self->n_livres--;
+    self->quadros[q].prox = -1;
+  }
+  return self;
+}
+
+void quadros_destroi(quadros_t *self)
+{
+  free(self->quadros);
+  free(self);
+}
+
+int quadros_num(quadros_t *self)
+{
+  return self->n_quadros;
+}
+
+int quadros_num_livres(quadros_t *self)
+{
+  return self->n_livres;
+}
+
+int quadros_aloca(quadros_t *self, int pid, tabpag_t *tabpag, int pagina,
+                  quadros_lista_t *lista)
+{
+  int quadro = self->livre;
+  if (quadro == -1) return -1;
+  quadro_t *q = &self->quadros[quadro];
+  self->livre = q->prox;
+  self->n_livres--;
+  q->pid = pid;
+  q->tabpag = tabpag;
+  q->pagina = pagina;
+  // no início da lista do dono
+  q->lista = lista;
+  q->ant = -1;
+  q->prox = *lista;
+  if (*lista != QUADROS_LISTA_VAZIA) self->quadros[*lista].ant = quadro;
+  *lista = quadro;
+  return quadro;
+}
+
+void quadros_libera(quadros_t *self, int quadro)
+{
+  quadro_t *q = &self->quadros[quadro];
+  assert(!q->fixo && q->lista != NULL);
+  // tira da lista do dono
+  if (q->ant == -1) {
+    *q->lista = q->prox;
+  } else {
+    self->quadros[q->ant].prox = q->prox;
+  }
+  if (q->prox != -1) self->quadros[q->prox].ant = q->ant;
+  if (q->em_transferencia) self->n_em_transferencia--;
+  quadros__poe_na_lista_livre(self, quadro);
+}
+
+bool quadros_livre(quadros_t *self, int quadro)
+{
+  quadro_t *q = &self->quadros[quadro];
+  return q->pid == 0 && !q->fixo;
+}
+
+bool quadros_fixo(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].fixo;
+}
+
+int quadros_pid(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].pid;
+}
+
+tabpag_t *quadros_tabpag(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].tabpag;
+}
+
+int quadros_pagina(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].pagina;
+}
+
+int quadros_proximo_do_dono(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].prox;
+}
+
+void quadros_define_em_transferencia(quadros_t *self, int quadro,
+                                     bool em_transferencia)
+{
+  quadro_t *q = &self->quadros[quadro];
+  assert(q->tabpag != NULL);
+  if (q->em_transferencia == em_transferencia) return;
+  q->em_transferencia = em_transferencia;
+  self->n_em_transferencia += em_transferencia ? 1 : -1;
+}
+
+bool quadros_em_transferencia(quadros_t *self, int quadro)
+{
+  return self->quadros[quadro].em_transferencia;
+}
+
+int quadros_num_em_transferencia(quadros_t *self)
+{
+  return self->n_em_transferencia;
+}
+
+bool quadros_substituivel(quadros_t *self, int quadro)
+{
+  quadro_t *q = &self->quadros[quadro];
+  return q->tabpag != NULL && !q->em_transferencia;
+}
@@ -0,0 +1,89 @@
+#ifndef QUADROS_H
+#define QUADROS_H
+
+// tabela de quadros
+// estrutura auxiliar para o SO
+// guarda, para cada quadro da memória principal, qual página de qual
+//   processo está nele; é o mapeamento inverso das tabelas de páginas,
+//   usado pelos algoritmos de substituição de páginas para encontrar a
+//   página que ocupa cada quadro (e seus bits de acesso e alteração)
+// mantém também os quadros livres, para alocação e liberação em tempo
+//   constante, e a lista dos quadros de cada dono, para liberar todos eles
+//   sem percorrer a tabela
+// os primeiros quadros (os da memória do SO) são fixos: nunca são alocados
+//   nem podem ser substituídos
+// um quadro ocupado pode estar em transferência (a página está sendo lida
+//   da memória secundária para ele, ou a que estava nele sendo gravada);
+//   enquanto isso não pode ser substituído
+
+#include "tabpag.h"
+#include <stdbool.h>
+
+typedef struct quadros_t quadros_t;
+
+// lista dos quadros de um dono, mantida pela tabela de quadros
+// o dono guarda a variável, inicializada com QUADROS_LISTA_VAZIA, e a
+//   passa na alocação de cada quadro; ela contém o primeiro quadro da
+//   lista (ou QUADROS_LISTA_VAZIA se não tiver nenhum)
+typedef int quadros_lista_t;
+#define QUADROS_LISTA_VAZIA -1
+
+// cria uma tabela para 'n_quadros' quadros, dos quais os 'n_fixos'
+//   primeiros são fixos e os demais estão livres
+// retorna NULL em caso de erro
+quadros_t *quadros_cria(int n_quadros, int n_fixos);
+
+// destrói a tabela de quadros
+void quadros_destroi(quadros_t *self);
+
+// retorna o número de quadros da tabela
+int quadros_num(quadros_t *self);
+
+// retorna o número de quadros livres
+int quadros_num_livres(quadros_t *self);
+
+// aloca um quadro livre para a página 'pagina' do processo 'pid', que tem
+//   a tabela de páginas 'tabpag'; o quadro é colocado na lista 'lista'
+// retorna o número do quadro, ou -1 se não tiver quadro livre
+int quadros_aloca(quadros_t *self, int pid, tabpag_t *tabpag, int pagina,
+                  quadros_lista_t *lista);
+
+// libera o quadro 'quadro', que deve estar ocupado, tirando-o da lista do
+//   dono
+void quadros_libera(quadros_t *self, int quadro);
+
+// retorna true se o quadro está livre
+bool quadros_livre(quadros_t *self, int quadro);
+
+// retorna true se o quadro é fixo
+bool quadros_fixo(quadros_t *self, int quadro);
+
+// retorna o pid do dono do quadro (0 se livre ou fixo)
+int quadros_pid(quadros_t *self, int quadro);
+
+// retorna a tabela de páginas do dono do quadro (NULL se livre ou fixo)
+tabpag_t *quadros_tabpag(quadros_t *self, int quadro);
+
+// retorna a página que está no quadro (-1 se livre ou fixo)
+int quadros_pagina(quadros_t *self, int quadro);
+
+// retorna o quadro seguinte ao quadro 'quadro' na lista do dono, ou
+//   QUADROS_LISTA_VAZIA se for o último
+int quadros_proximo_do_dono(quadros_t *self, int quadro);
+
+// marca (ou desmarca, se 'em_transferencia' for false) o quadro ocupado
+//   'quadro' como em transferência
+void quadros_define_em_transferencia(quadros_t *self, int quadro,
+                                     bool em_transferencia);
+
+// retorna true se o quadro está em transferência
+bool quadros_em_transferencia(quadros_t *self, int quadro);
+
+// retorna o número de quadros em transferência
+int quadros_num_em_transferencia(quadros_t *self);
+
+// retorna true se o quadro pode ser escolhido para substituição: está
+//   ocupado por uma página de processo, e não está em transferência
+bool quadros_substituivel(quadros_t *self, int quadro);
+
+#endif // QUADROS_H
@@ -6,13 +6,17 @@ struct relogio_t {
   int agora;             // que horas são
   int t_ate_interrupcao; // quanto tempo até gerar uma interrupcao
   int interrupcao;       // 1 se está gerando interrupcao, 0 se não
+  pic_t *pic;            // onde sinaliza a interrupção
 };
 
-relogio_t *rel_cria(void)
+static void rel__muda_interrupcao(relogio_t *self, int interrupcao);
+
+relogio_t *rel_cria(pic_t *pic)
 {
   relogio_t *self;
   self = malloc(sizeof(relogio_t));
   if (self != NULL) {
+    self->pic = pic;
     self->agora = 0;
     self->t_ate_interrupcao = 0;
     self->interrupcao = 0;
@@ -27,16 +31,32 @@ void rel_destroi(relogio_t *self)
 
 void rel_tictac(relogio_t *self)
 {
-  self->agora++;
+  rel_avanca(self, 1);
+}
+
+void rel_avanca(relogio_t *self, int n)
+{
+  self->agora += n;
   // vê se tem que gerar interrupção
   if (self->t_ate_interrupcao != 0) {
-    self->t_ate_interrupcao--;
-    if (self->t_ate_interrupcao == 0) {
-      self->interrupcao = 1;
+    if (n >= self->t_ate_interrupcao) {
+      self->t_ate_interrupcao = 0;
+      rel__muda_interrupcao(self, 1);
+    } else {
+      self->t_ate_interrupcao -= n;
     }
   }
 }
 
+// altera o pedido de interrupção, repassando para o controlador
+static void rel__muda_interrupcao(relogio_t *self, int interrupcao)
+{
+  self->interrupcao = interrupcao;
+  if (self->pic != NULL) {
+    pic_sinaliza(self->pic, IRQ_RELOGIO, interrupcao != 0);
+  }
+}
+
 int rel_agora(relogio_t *self)
 {
   return self->agora;
@@ -74,7 +94,7 @@ err_t rel_escr(void *disp, int id, int pvalor)
       self->t_ate_interrupcao = pvalor;
       break;
     case 3:
-      self->interrupcao = (pvalor == 0) ? 0 : 1;
+      rel__muda_interrupcao(self, (pvalor == 0) ? 0 : 1);
       break;
     default: 
       err = ERR_END_INV;
@@ -5,12 +5,15 @@
 // registra a passagem do tempo
 
 #include "err.h"
+#include "pic.h"
 
 typedef struct relogio_t relogio_t;
 
 // cria e inicializa um relógio
+// o relógio sinaliza IRQ_RELOGIO no controlador de interrupções 'pic'
+//   enquanto estiver pedindo interrupção (dispositivo 3)
 // retorna NULL em caso de erro
-relogio_t *rel_cria(void);
+relogio_t *rel_cria(pic_t *pic);
 
 // destrói um relógio
 // nenhuma outra operação pode ser realizada no relógio após esta chamada
@@ -20,6 +23,11 @@ void rel_destroi(relogio_t *self);
 // esta função é chamada pelo controlador após a execução de cada instrução
 void rel_tictac(relogio_t *self);
 
+// registra a passagem de 'n' unidades de tempo de uma vez
+// equivale a 'n' chamadas a rel_tictac; o controlador limita a execução
+//   de um lote de instruções para não passar do tempo da interrupção
+void rel_avanca(relogio_t *self, int n);
+
 // retorna a hora atual do sistema, em unidades de tempo
 int rel_agora(relogio_t *self);
 
@@ -0,0 +1,99 @@
+#include "simbolos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// tamanho máximo de um nome de símbolo
+#define TAM_NOME 50
+
+typedef struct {
+  char nome[TAM_NOME];
+  int endereco;
+} simbolo_t;
+
+struct simbolos_t {
+  simbolo_t *simbolos;   // em ordem de endereço
+  int n_simbolos;
+};
+
+static int compara_simbolos(const void *a, const void *b)
+{
+  const simbolo_t *sa = a;
+  const simbolo_t *sb = b;
+  return sa->endereco - sb->endereco;
+}
+
+simbolos_t *simb_cria(char *nome)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) return NULL;
+  simbolos_t *self = malloc(sizeof(*self));
+  if (self == NULL) {
+    fclose(arq);
+    return NULL;
+  }
+  self->simbolos = NULL;
+  self->n_simbolos = 0;
+  int cap = 0;
+  char nome_simb[TAM_NOME];
+  int endereco;
+  while (fscanf(arq, "%49s %d", nome_simb, &endereco) == 2) {
+    if (self->n_simbolos >= cap) {
+      cap = cap == 0 ? 32 : cap * 2;
+      simbolo_t *novos = realloc(self->simbolos, cap * sizeof(*novos));
+      if (novos == NULL) break;
+      self->simbolos = novos;
+    }
+    simbolo_t *simb = &self->simbolos[self->n_simbolos++];
+    strcpy(simb->nome, nome_simb);
+    simb->endereco = endereco;
+  }
+  fclose(arq);
+  // o montador gera em ordem, mas não custa garantir
+  qsort(self->simbolos, self->n_simbolos, sizeof(simbolo_t), compara_simbolos);
+  return self;
+}
+
+void simb_destroi(simbolos_t *self)
+{
+  if (self == NULL) return;
+  free(self->simbolos);
+  free(self);
+}
+
+// retorna o índice do símbolo com o maior endereço que não é maior que
+//   'endereco', ou -1 se não tiver
+static int simb__busca(simbolos_t *self, int endereco)
+{
+  if (self == NULL) return -1;
+  int ini = 0;
+  int fim = self->n_simbolos - 1;
+  int achou = -1;
+  while (ini <= fim) {
+    int meio = (ini + fim) / 2;
+    if (self->simbolos[meio].endereco <= endereco) {
+      achou = meio;
+      ini = meio + 1;
+    } else {
+      fim = meio - 1;
+    }
+  }
+  return achou;
+}
+
+void simb_descreve(simbolos_t *self, int endereco, int tam, char str[tam])
+{
+  int i = simb__busca(self, endereco);
+  if (i < 0) {
+    snprintf(str, tam, "%d", endereco);
+    return;
+  }
+  simbolo_t *simb = &self->simbolos[i];
+  int desl = endereco - simb->endereco;
+  if (desl == 0) {
+    snprintf(str, tam, "%s", simb->nome);
+  } else {
+    snprintf(str, tam, "%s+%d", simb->nome, desl);
+  }
+}
@@ -0,0 +1,27 @@
+#ifndef SIMBOLOS_H
+#define SIMBOLOS_H
+
+// TAD para representar o mapa de símbolos de um programa, lido de um
+//   arquivo '.sym' gerado pelo montador (opção -s)
+// o arquivo tem uma linha para cada label de posição de memória do
+//   programa, com o nome e o endereço do label
+// serve para mostrar endereços de um programa pelo nome (como
+//   "impnum+12"), no perfil e em mensagens
+
+typedef struct simbolos_t simbolos_t;
+
+// cria um mapa de símbolos com o conteúdo do arquivo 'nome'
+// retorna NULL em caso de erro (se o arquivo não existe, por exemplo)
+simbolos_t *simb_cria(char *nome);
+
+// destrói um mapa de símbolos
+void simb_destroi(simbolos_t *self);
+
+// coloca em 'str' a descrição simbólica de 'endereco': o nome do label
+//   com o maior endereço que não é maior que 'endereco', mais o
+//   deslocamento, se não for 0 ("impnum", "impnum+12")
+// se não tiver label antes do endereço (ou se self for NULL), a descrição
+//   é o próprio número
+void simb_descreve(simbolos_t *self, int endereco, int tam, char str[tam]);
+
+#endif // SIMBOLOS_H
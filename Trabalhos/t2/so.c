@@ -3,23 +3,144 @@
 #include "programa.h"
 #include "instrucao.h"
 #include "tabpag.h"
+#include "log.h"
+#include "simbolos.h"
+#include "quadros.h"
+#include "subst.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <assert.h>
 
 // intervalo entre interrupções do relógio
 #define INTERVALO_INTERRUPCAO 50   // em instruções executadas
 
-// Não tem processos nem memória virtual, mas é preciso usar a paginação,
-//   pelo menos para implementar relocação, já que os programas estão sendo
-//   todos montados para serem executados no endereço 0 e o endereço 0
-//   físico é usado pelo hardware nas interrupções.
-// Os programas vão ser carregados no início de um quadro, e usar quantos
-//   quadros forem necessárias. Para isso a variável quadro_livre vai conter
-//   o número do primeiro quadro da memória principal que ainda não foi usado.
-//   Na carga do processo, a tabela de páginas (deveria ter uma por processo,
-//   mas não tem processo) é alterada para que o endereço virtual 0 resulte
-//   no quadro onde o programa foi carregado.
+// tempo que um processo pode executar antes de ser preemptado
+#define QUANTUM 5                  // em interrupções do relógio
+
+// número máximo de processos existindo ao mesmo tempo
+#define MAX_PROCESSOS 16
+
+// número de terminais na console; o terminal t usa os dispositivos 4t
+//   (leitura), 4t+1 (estado da leitura), 4t+2 (escrita) e 4t+3 (estado da
+//   escrita)
+#define N_TERM 4
+
+// programa executado pelo processo inicial, se não for definido outro
+#define PROGRAMA_INICIAL "init.maq"
+
+// número máximo de programas diferentes com mapa de símbolos carregado
+#define MAX_PROGRAMAS 16
+
+// tempo de transferência de uma página entre a memória principal e a
+//   secundária
+#define TEMPO_DISCO 20             // em instruções executadas
+
+// algoritmo de substituição de páginas e tamanho da janela do conjunto de
+//   trabalho (para o wsclock), se não forem definidos outros
+#define SUBST_PADRAO SUBST_FIFO
+#define TAU_PADRAO 10              // em interrupções do relógio
+
+// organização das tabelas de páginas dos processos, se não for definida
+//   outra
+#define TABPAG_PADRAO TABPAG_LINEAR
+
+// número de quadros que cada processo na memória deve poder ocupar: uma
+//   instrução pode precisar de 3 páginas ao mesmo tempo (a do opcode, a do
+//   argumento e a do dado acessado)
+#define MIN_QUADROS_POR_PROCESSO 3
+
+// Memória virtual com paginação por demanda
+// Cada processo tem sua tabela de páginas. Na criação do processo, o
+//   programa é carregado na memória secundária, em blocos consecutivos do
+//   tamanho de uma página, e a tabela de páginas fica vazia. Cada acesso a
+//   uma página que não está na memória principal causa uma falta de
+//   página, e o SO copia a página para um quadro livre (ou liberado pelo
+//   algoritmo de substituição, que grava de volta a página que estava
+//   nele se tiver sido alterada). O processo fica bloqueado pelo tempo das
+//   transferências com o disco.
+// A memória principal abaixo do endereço 100 é do SO (tem o tratador de
+//   interrupção no endereço 10): esses quadros são fixos na tabela de
+//   quadros, os demais são dos processos. O quadro que recebe uma página
+//   fica em transferência (não pode ser substituído) até o fim da espera
+//   do processo pelo disco.
+// Controle de carga: com poucos quadros, processos demais disputando a
+//   memória tiram as páginas uns dos outros antes de conseguirem executar
+//   uma instrução, e nenhum avança. Só podem executar os processos que
+//   têm uma vaga na memória; o número de vagas é tal que cada um pode ter
+//   MIN_QUADROS_POR_PROCESSO quadros. Os demais ficam bloqueados na fila
+//   da memória. Um processo libera sua vaga quando morre, quando bloqueia
+//   esperando um evento que pode demorar (terminal ou morte de outro
+//   processo) e quando acaba seu quantum se tiver outro esperando vaga.
+
+typedef struct processo_t processo_t;
+
+// resultado do atendimento de uma falta de página, ou de um acesso do SO à
+//   memória de um processo, que pode causar faltas de página
+typedef enum {
+  ACESSO_OK,         // a página foi trazida (ou o acesso foi feito)
+  ACESSO_ADIADO,     // não tinha quadro que pudesse receber a página (todos
+                     //   em transferência): o processo espera o disco, e o
+                     //   acesso deve ser refeito depois
+  ACESSO_INVALIDO,   // o endereço não pertence ao processo (ou não tem
+                     //   quadro que possa ser usado, ou a string é inválida)
+} acesso_t;
+
+// fila de processos bloqueados esperando por um mesmo evento
+// os processos são encadeados pelo campo prox_na_fila do descritor
+typedef struct {
+  processo_t *primeiro;
+  processo_t *ultimo;
+} fila_t;
+
+// descritor de processo
+struct processo_t {
+  int pid;
+  enum { livre, pronto, bloqueado } estado;
+  // estado da CPU quando o processo não está executando
+  cpu_estado_t regs;
+  // tabela de páginas do processo
+  tabpag_t *tabpag;
+  // se bloqueado, a fila onde está esperando, e o próximo nessa fila
+  fila_t *fila;
+  processo_t *prox_na_fila;
+  // se bloqueado em SO_ESPERA_PROC, o pid esperado
+  int pid_esperado;
+  // terminal usado para E/S
+  int terminal;
+  // mapa de símbolos do programa (NULL se não tiver), para as mensagens
+  simbolos_t *simbolos;
+  // páginas do processo (as que contêm o programa) e onde estão na memória
+  //   secundária: a página pagina_ini está no bloco bloco_sec, as
+  //   seguintes nos blocos seguintes
+  int pagina_ini;
+  int n_paginas;
+  int bloco_sec;
+  // tempo de execução, em interrupções do relógio (usado pelo wsclock)
+  int tempo;
+  // se bloqueado esperando o disco, quando as transferências terminam
+  int fim_espera_disco;
+  // número de faltas de página atendidas
+  int n_faltas;
+  // quadros da memória principal ocupados pelo processo
+  quadros_lista_t quadros;
+  // se tem vaga na memória (ver controle de carga)
+  bool tem_vaga;
+  // cópia de string da memória do processo que foi adiada (ver
+  //   so_copia_str_do_processo): o que já foi copiado, para continuar de
+  //   onde parou quando a chamada de sistema for refeita
+  char str_copiada[100];
+  int n_copiado;
+};
+
+// mapa de símbolos de um programa, lido do arquivo .sym junto ao .maq
+// cada programa tem o mapa lido uma vez só, e mantido até o fim (o perfil
+//   usa depois que os processos morrem)
+typedef struct {
+  char nome[100];
+  simbolos_t *simbolos;
+} programa_simb_t;
 
 struct so_t {
   cpu_t *cpu;
@@ -27,12 +148,47 @@ struct so_t {
   mmu_t *mmu;
   console_t *console;
   relogio_t *relogio;
-  // quando tiver memória virtual, o controle de memória livre e ocupada
-  //   é mais completo que isso
-  int quadro_livre;
-  // quando tiver processos, não tem essa tabela aqui, tem que tem uma para
-  //   cada processo
-  tabpag_t *tabpag;
+  log_t *log;
+  // memória principal: quem está em cada quadro (e os quadros livres) e
+  //   quem escolhe o quadro a liberar quando não tiver livre
+  quadros_t *quadros;
+  subst_t *subst;
+  // organização das tabelas de páginas criadas
+  tabpag_tipo_t tipo_tabpag;
+  // memória secundária, dividida em blocos do tamanho de uma página
+  mem_t *mem_sec;
+  bool *bloco_ocupado;
+  int n_blocos;
+  // quando o disco termina as transferências já pedidas
+  int disco_livre;
+  // faltas de página atendidas, de todos os processos
+  long n_faltas;
+  // vagas na memória para processos, e quantas estão ocupadas
+  int n_vagas;
+  int n_vagas_ocupadas;
+  // tabela de processos
+  processo_t processos[MAX_PROCESSOS];
+  // processo em execução, NULL se nenhum
+  processo_t *processo_corrente;
+  // interrupções do relógio que faltam para terminar o quantum do
+  //   processo corrente
+  int quantum;
+  // pid do próximo processo a ser criado
+  int proximo_pid;
+  // filas de processos bloqueados: esperando para ler e para escrever em
+  //   cada terminal, e esperando a morte de outro processo
+  fila_t fila_le[N_TERM];
+  fila_t fila_escr[N_TERM];
+  fila_t fila_espera;
+  // processos bloqueados esperando transferência de página
+  fila_t fila_disco;
+  // processos prontos esperando vaga na memória
+  fila_t fila_memoria;
+  // programa do processo inicial
+  char programa_inicial[100];
+  // mapas de símbolos dos programas já carregados
+  programa_simb_t programas[MAX_PROGRAMAS];
+  int n_programas;
 };
 
 
@@ -40,35 +196,59 @@ struct so_t {
 static err_t so_trata_interrupcao(void *argC, int reg_A);
 
 // funções auxiliares
-static int so_carrega_programa(so_t *self, char *nome_do_executavel);
-static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
-                                     int end_virt/*, processo*/);
+static processo_t *so_cria_processo(so_t *self, char *nome_do_executavel);
+static void so_mata_processo(so_t *self, processo_t *proc);
+static processo_t *so_busca_processo(so_t *self, int pid);
+static void so_bloqueia(so_t *self, processo_t *proc, fila_t *fila);
+static void so_desbloqueia(so_t *self, processo_t *proc);
+static void so_espera_evento(so_t *self, processo_t *proc, fila_t *fila);
+static void so_acorda(so_t *self, processo_t *proc);
+static void so_ocupa_vaga(so_t *self, processo_t *proc);
+static void so_libera_vaga(so_t *self, processo_t *proc);
+static int so_carrega_programa(so_t *self, processo_t *proc,
+                               char *nome_do_executavel);
+static acesso_t so_copia_str_do_processo(so_t *self, int tam, char str[tam],
+                                         int end_virt, processo_t *proc);
+static simbolos_t *so_simbolos_do_programa(so_t *self,
+                                           char *nome_do_executavel);
+static acesso_t so_trata_falta_de_pagina(so_t *self, processo_t *proc,
+                                         int end_virt);
+static void so_libera_blocos_sec(so_t *self, int primeiro, int n);
+static void so_fim_das_transferencias(so_t *self, processo_t *proc);
+static void so_libera_memoria(so_t *self, processo_t *proc);
+static int so_tempo_do_processo(void *arg, int pid);
 
 
 
-so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
-              console_t *console, relogio_t *relogio)
+so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_sec, mmu_t *mmu,
+              console_t *console, relogio_t *relogio, log_t *log)
 {
   so_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
 
   self->cpu = cpu;
   self->mem = mem;
+  self->mem_sec = mem_sec;
   self->mmu = mmu;
   self->console = console;
   self->relogio = relogio;
+  self->log = log;
 
   // quando a CPU executar uma instrução CHAMAC, deve chamar a função
   //   so_trata_interrupcao
   cpu_define_chamaC(self->cpu, so_trata_interrupcao, self);
+  // o estado da CPU interrompida é obtido e alterado diretamente na CPU
+  //   (cpu_salva_estado e cpu_restaura_estado), não precisa passar pela
+  //   memória
+  cpu_define_estado_na_memoria(self->cpu, false);
 
   // coloca o tratador de interrupção na memória
   // quando a CPU aceita uma interrupção, passa para modo supervisor, 
-  //   salva seu estado à partir do endereço 0, e desvia para o endereço 10
+  //   salva seu estado, e desvia para o endereço 10
   // colocamos no endereço 10 a instrução CHAMAC, que vai chamar 
   //   so_trata_interrupcao (conforme foi definido acima) e no endereço 11
   //   colocamos a instrução RETI, para que a CPU retorne da interrupção
-  //   (recuperando seu estado no endereço 0) depois que o SO retornar de
+  //   (recuperando seu estado salvo) depois que o SO retornar de
   //   so_trata_interrupcao.
   mem_escreve(self->mem, 10, CHAMAC);
   mem_escreve(self->mem, 11, RETI);
@@ -76,23 +256,99 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
   // programa o relógio para gerar uma interrupção após INTERVALO_INTERRUPCAO
   rel_escr(self->relogio, 2, INTERVALO_INTERRUPCAO);
 
-  // inicializa a tabela de páginas global, e entrega ela para a MMU
-  // com processos, essa tabela não existiria, teria uma por processo
-  self->tabpag = tabpag_cria();
-  mmu_define_tabpag(self->mmu, self->tabpag);
-  // define o primeiro quadro livre de memória como o seguinte àquele que
-  //   contém o endereço 99 (as 100 primeiras posições de memória (pelo menos)
-  //   não vão ser usadas por programas de usuário)
-  self->quadro_livre = 99 / TAM_PAGINA + 1;
+  // inicializa a tabela de processos
+  for (int i = 0; i < MAX_PROCESSOS; i++) {
+    self->processos[i].estado = livre;
+  }
+  self->processo_corrente = NULL;
+  self->quantum = 0;
+  self->proximo_pid = 1;
+  for (int t = 0; t < N_TERM; t++) {
+    self->fila_le[t].primeiro = self->fila_le[t].ultimo = NULL;
+    self->fila_escr[t].primeiro = self->fila_escr[t].ultimo = NULL;
+  }
+  self->fila_espera.primeiro = self->fila_espera.ultimo = NULL;
+  self->fila_disco.primeiro = self->fila_disco.ultimo = NULL;
+  self->fila_memoria.primeiro = self->fila_memoria.ultimo = NULL;
+  self->n_programas = 0;
+  strcpy(self->programa_inicial, PROGRAMA_INICIAL);
+
+  // os quadros até o que contém o endereço 99 são fixos (as 100 primeiras
+  //   posições de memória (pelo menos) não vão ser usadas por programas de
+  //   usuário)
+  int tam_pagina = mmu_tam_pagina(self->mmu);
+  self->quadros = quadros_cria(mem_tam(self->mem) / tam_pagina,
+                               99 / tam_pagina + 1);
+  self->subst = NULL;
+  self->tipo_tabpag = TABPAG_PADRAO;
+  if (self->quadros != NULL) {
+    self->subst = subst_cria(SUBST_PADRAO, self->quadros, TAU_PADRAO,
+                             so_tempo_do_processo, self);
+  }
+  self->n_blocos = mem_tam(self->mem_sec) / tam_pagina;
+  self->bloco_ocupado = calloc(self->n_blocos, sizeof(bool));
+  self->disco_livre = 0;
+  self->n_faltas = 0;
+  // com menos quadros que MIN_QUADROS_POR_PROCESSO, nenhum processo tem
+  //   garantia de conseguir executar (ver so_trata_irq_reset)
+  self->n_vagas = 0;
+  if (self->quadros != NULL) {
+    self->n_vagas = quadros_num_livres(self->quadros)
+                    / MIN_QUADROS_POR_PROCESSO;
+  }
+  self->n_vagas_ocupadas = 0;
+  if (self->quadros == NULL || self->subst == NULL
+      || self->bloco_ocupado == NULL) {
+    so_destroi(self);
+    return NULL;
+  }
   return self;
 }
 
 void so_destroi(so_t *self)
 {
   cpu_define_chamaC(self->cpu, NULL, NULL);
+  mmu_define_tabpag(self->mmu, NULL);
+  for (int i = 0; i < MAX_PROCESSOS; i++) {
+    if (self->processos[i].estado != livre) {
+      tabpag_destroi(self->processos[i].tabpag);
+    }
+  }
+  for (int i = 0; i < self->n_programas; i++) {
+    simb_destroi(self->programas[i].simbolos);
+  }
+  if (self->subst != NULL) subst_destroi(self->subst);
+  if (self->quadros != NULL) quadros_destroi(self->quadros);
+  free(self->bloco_ocupado);
   free(self);
 }
 
+void so_define_programa_inicial(so_t *self, char *nome)
+{
+  strncpy(self->programa_inicial, nome, 99);
+  self->programa_inicial[99] = '\0';
+}
+
+bool so_define_substituicao(so_t *self, subst_alg_t alg, int tau)
+{
+  subst_t *subst = subst_cria(alg, self->quadros, tau, so_tempo_do_processo,
+                              self);
+  if (subst == NULL) return false;
+  subst_destroi(self->subst);
+  self->subst = subst;
+  return true;
+}
+
+void so_define_tipo_tabpag(so_t *self, tabpag_tipo_t tipo)
+{
+  self->tipo_tabpag = tipo;
+}
+
+long so_num_faltas_de_pagina(so_t *self)
+{
+  return self->n_faltas;
+}
+
 
 // Tratamento de interrupção
 
@@ -101,6 +357,9 @@ static err_t so_trata_irq(so_t *self, int irq);
 static err_t so_trata_irq_reset(so_t *self);
 static err_t so_trata_irq_err_cpu(so_t *self);
 static err_t so_trata_irq_relogio(so_t *self);
+static bool so_relogio_causa_troca(so_t *self);
+static err_t so_trata_irq_teclado(so_t *self);
+static err_t so_trata_irq_tela(so_t *self);
 static err_t so_trata_irq_desconhecida(so_t *self, int irq);
 static err_t so_trata_chamada_sistema(so_t *self);
 
@@ -108,7 +367,8 @@ static err_t so_trata_chamada_sistema(so_t *self);
 static void so_salva_estado_da_cpu(so_t *self);
 static void so_trata_pendencias(so_t *self);
 static void so_escalona(so_t *self);
-static void so_despacha(so_t *self);
+static err_t so_despacha(so_t *self);
+static bool so_bloqueados_podem_continuar(so_t *self);
 
 // função a ser chamada pela CPU quando executa a instrução CHAMAC
 // essa instrução só deve ser executada quando for tratar uma interrupção
@@ -116,13 +376,25 @@ static void so_despacha(so_t *self);
 //   da interrupção
 // na inicialização do SO é colocada no endereço 10 uma rotina que executa
 //   CHAMAC; quando recebe uma interrupção, a CPU salva os registradores
-//   no endereço 0, e desvia para o endereço 10
+//   (no banco interno dela), e desvia para o endereço 10
+// o valor retornado vai para o registrador de erro da CPU: ERR_CPU_PARADA
+//   quando não existe mais processo (fim normal), ERR_SO se o SO não tem
+//   como continuar por um erro interno (o programa inicial não pôde ser
+//   carregado, por exemplo) ou porque nenhum processo vai poder voltar a
+//   executar (esperam entrada em terminais que não vão ter mais)
 static err_t so_trata_interrupcao(void *argC, int reg_A)
 {
   so_t *self = argC;
   irq_t irq = reg_A;
   err_t err;
-  console_printf(self->console, "SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
+  // caminho rápido para a interrupção do relógio que não acaba o quantum:
+  //   nada muda além da contabilidade, o processo interrompido continua
+  //   executando com o estado que está na CPU, não precisa salvar,
+  //   escalonar e despachar
+  if (irq == IRQ_RELOGIO && !so_relogio_causa_troca(self)) {
+    return so_trata_irq_relogio(self);
+  }
+  LOG_TRACO(self->log, LOG_IRQ, LOG_MSG_IRQ, irq, irq);
   // salva o estado da cpu no descritor do processo que foi interrompido
   so_salva_estado_da_cpu(self);
   // faz o atendimento da interrupção
@@ -132,37 +404,123 @@ static err_t so_trata_interrupcao(void *argC, int reg_A)
   // escolhe o próximo processo a executar
   so_escalona(self);
   // recupera o estado do processo escolhido
-  so_despacha(self);
+  if (err == ERR_OK) {
+    err = so_despacha(self);
+  }
   return err;
 }
 
 static void so_salva_estado_da_cpu(so_t *self)
 {
   // se não houver processo corrente, não faz nada
+  processo_t *proc = self->processo_corrente;
+  if (proc == NULL) return;
   // salva os registradores que compõem o estado da cpu no descritor do
   //   processo corrente
-  // mem_le(self->mem, IRQ_END_A, endereco onde vai o A no descritor);
-  // mem_le(self->mem, IRQ_END_X, endereco onde vai o X no descritor);
-  // etc
+  cpu_salva_estado(self->cpu, &proc->regs);
 }
+
 static void so_trata_pendencias(so_t *self)
 {
   // realiza ações que não são diretamente ligadar com a interrupção que
   //   está sendo atendida:
-  // - E/S pendente
-  // - desbloqueio de processos
   // - contabilidades
+  // - desbloqueio dos processos cujas transferências de página terminaram
+  // os outros processos bloqueados são desbloqueados no tratamento da
+  //   interrupção do dispositivo que esperam (ou na morte do processo
+  //   esperado), não precisam ser verificados aqui
+  int agora = rel_agora(self->relogio);
+  processo_t *proc = self->fila_disco.primeiro;
+  while (proc != NULL) {
+    processo_t *prox = proc->prox_na_fila;
+    if (proc->fim_espera_disco <= agora) {
+      so_fim_das_transferencias(self, proc);
+      so_desbloqueia(self, proc);
+    }
+    proc = prox;
+  }
 }
+
 static void so_escalona(so_t *self)
 {
   // escolhe o próximo processo a executar, que passa a ser o processo
   //   corrente; pode continuar sendo o mesmo de antes ou não
+  // o processo corrente continua se estiver pronto e não tiver acabado seu
+  //   quantum; senão, escolhe o próximo pronto na tabela, circularmente
+  //   (o corrente é o último a ser considerado)
+  processo_t *atual = self->processo_corrente;
+  if (atual != NULL && atual->estado == pronto && self->quantum > 0) return;
+  // acabou o quantum; se tem processo esperando vaga na memória, o atual
+  //   cede a sua e vai para o final da fila
+  if (atual != NULL && atual->estado == pronto
+      && self->fila_memoria.primeiro != NULL) {
+    so_libera_vaga(self, atual);
+    so_ocupa_vaga(self, atual);
+  }
+  int ini = (atual == NULL) ? 0 : (atual - self->processos) + 1;
+  for (int n = 0; n < MAX_PROCESSOS; n++) {
+    processo_t *proc = &self->processos[(ini + n) % MAX_PROCESSOS];
+    if (proc->estado == pronto) {
+      self->processo_corrente = proc;
+      self->quantum = QUANTUM;
+      return;
+    }
+  }
+  self->processo_corrente = NULL;
 }
-static void so_despacha(so_t *self)
+
+static err_t so_despacha(so_t *self)
 {
-  // se não houver processo corrente, coloca ERR_CPU_PARADA em IRQ_END_erro
-  // se houver processo corrente, coloca todo o estado desse processo em
-  //   IRQ_END_*
+  processo_t *proc = self->processo_corrente;
+  if (proc == NULL) {
+    // sem processo para executar; se não existe processo nenhum, não tem
+    //   mais o que fazer, para a CPU em modo supervisor
+    bool tem_processo = false;
+    for (int i = 0; i < MAX_PROCESSOS; i++) {
+      if (self->processos[i].estado != livre) tem_processo = true;
+    }
+    if (!tem_processo) {
+      LOG_INFO(self->log, LOG_SO, LOG_MSG_SEM_PROCESSO);
+      return ERR_CPU_PARADA;
+    }
+    // tem processo bloqueado; se nenhum deles tem como ser desbloqueado,
+    //   também não tem mais o que fazer, mas não é um fim normal
+    if (!so_bloqueados_podem_continuar(self)) {
+      LOG_ERRO(self->log, LOG_SO, LOG_MSG_SEM_ENTRADA);
+      return ERR_SO;
+    }
+    // a CPU fica parada em modo usuário, esperando uma interrupção
+    cpu_estado_t parada = { .erro = ERR_CPU_PARADA, .modo = usuario };
+    cpu_restaura_estado(self->cpu, &parada);
+    return ERR_OK;
+  }
+  // entrega para a CPU o estado do processo corrente, que ela vai
+  //   recuperar na execução de RETI
+  proc->regs.erro = ERR_OK;
+  cpu_restaura_estado(self->cpu, &proc->regs);
+  mmu_define_tabpag(self->mmu, proc->tabpag);
+  return ERR_OK;
+}
+
+// retorna false se nenhum processo bloqueado vai ser desbloqueado: não
+//   tem transferência de página em andamento, nem processo esperando vaga
+//   na memória ou para escrever, e os que esperam para ler estão em
+//   terminais cuja entrada acabou (ver CONSOLE_ENTRADA_ESGOTADA)
+// os que esperam a morte de outro processo não contam, o outro também
+//   está bloqueado
+static bool so_bloqueados_podem_continuar(so_t *self)
+{
+  if (self->fila_disco.primeiro != NULL) return true;
+  if (self->fila_memoria.primeiro != NULL) return true;
+  int esgotados;
+  term_le(self->console, CONSOLE_ENTRADA_ESGOTADA, &esgotados);
+  for (int t = 0; t < N_TERM; t++) {
+    if (self->fila_escr[t].primeiro != NULL) return true;
+    if (self->fila_le[t].primeiro != NULL && (esgotados & (1 << t)) == 0) {
+      return true;
+    }
+  }
+  return false;
 }
 
 static err_t so_trata_irq(so_t *self, int irq)
@@ -181,6 +539,12 @@ static err_t so_trata_irq(so_t *self, int irq)
     case IRQ_RELOGIO:
       err = so_trata_irq_relogio(self);
       break;
+    case IRQ_TECLADO:
+      err = so_trata_irq_teclado(self);
+      break;
+    case IRQ_TELA:
+      err = so_trata_irq_tela(self);
+      break;
     default:
       err = so_trata_irq_desconhecida(self, irq);
   }
@@ -189,44 +553,46 @@ static err_t so_trata_irq(so_t *self, int irq)
 
 static err_t so_trata_irq_reset(so_t *self)
 {
-  // coloca o programa "init" na memória
-  // vai programar a tabela de páginas para traduzir os endereços virtuais
-  //   a partir de 0 para o endereço onde ele foi carregado.
-  int ender = so_carrega_programa(self, "init.maq");
-  if (ender < 0) {
-    console_printf(self->console, "SO: problema na carga do programa inicial");
-    return ERR_CPU_PARADA;
-  }
-
-  // deveria criar um processo para o init, e inicializar o estado do
-  //   processador para esse processo com os registradores zerados, exceto
-  //   o PC e o modo.
-  // como não tem suporte a processos, está carregando os valores dos
-  //   registradores diretamente para a memória, de onde a CPU vai carregar
-  //   para os seus registradores quando executar a instrução RETI
-
-  // altera o PC para o endereço de carga (deve ter sido o endereço virtual 0)
-  mem_escreve(self->mem, IRQ_END_PC, ender);
-  // passa o processador para modo usuário
-  mem_escreve(self->mem, IRQ_END_modo, usuario);
+  // cria o processo inicial, para executar o programa inicial ("init")
+  // o escalonador vai escolher esse processo (é o único), e o despacho
+  //   vai colocar o estado dele onde a CPU vai recuperar quando executar
+  //   a instrução RETI
+  if (self->n_vagas == 0) {
+    LOG_ERRO(self->log, LOG_SO, LOG_MSG_POUCOS_QUADROS,
+             quadros_num_livres(self->quadros), MIN_QUADROS_POR_PROCESSO);
+    return ERR_SO;
+  }
+  if (so_cria_processo(self, self->programa_inicial) == NULL) {
+    LOG_ERRO(self->log, LOG_SO, LOG_MSG_ERRO_INIT);
+    return ERR_SO;
+  }
   return ERR_OK;
 }
 
 static err_t so_trata_irq_err_cpu(so_t *self)
 {
   // Ocorreu um erro interno na CPU
-  // O erro está codificado em IRQ_END_erro
-  // Em geral, causa a morte do processo que causou o erro
-  // Ainda não temos processos, causa a parada da CPU
-  int err_int;
-  // com suporte a processos, deveria pegar o valor do registrador erro
-  //   no descritor do processo corrente, e reagir de acordo com esse erro
-  //   (em geral, matando o processo)
-  mem_le(self->mem, IRQ_END_erro, &err_int);
-  err_t err = err_int;
-  console_printf(self->console,
-      "SO: IRQ não tratada -- erro na CPU: %s", err_nome(err));
-  return ERR_CPU_PARADA;
+  // O erro está codificado no registrador erro do processo que estava
+  //   executando; causa a morte desse processo
+  processo_t *proc = self->processo_corrente;
+  if (proc == NULL) {
+    LOG_ERRO(self->log, LOG_IRQ, LOG_MSG_ERR_CPU_SEM_PROC);
+    return ERR_SO;
+  }
+  // pode ser uma falta de página; atendida ou adiada, a instrução vai ser
+  //   executada de novo quando o processo voltar a executar
+  err_t erro = proc->regs.erro;
+  if ((erro == ERR_PAG_AUSENTE || erro == ERR_END_INV)
+      && so_trata_falta_de_pagina(self, proc, proc->regs.complemento)
+         != ACESSO_INVALIDO) {
+    return ERR_OK;
+  }
+  char onde[30];
+  simb_descreve(proc->simbolos, proc->regs.PC, 30, onde);
+  LOG_INFO_STR(self->log, LOG_PROC, LOG_MSG_PROC_MORTO_POR_ERRO, onde,
+               proc->pid, proc->regs.erro, proc->regs.complemento);
+  so_mata_processo(self, proc);
+  return ERR_OK;
 }
 
 static err_t so_trata_irq_relogio(so_t *self)
@@ -235,219 +601,668 @@ static err_t so_trata_irq_relogio(so_t *self)
   // rearma o interruptor do relógio e reinicializa o timer para a próxima interrupção
   rel_escr(self->relogio, 3, 0); // desliga o sinalizador de interrupção
   rel_escr(self->relogio, 2, INTERVALO_INTERRUPCAO);
-  // trata a interrupção
-  // por exemplo, decrementa o quantum do processo corrente, quando se tem
-  // um escalonador com quantum
-  console_printf(self->console, "SO: interrupção do relógio (não tratada)");
+  // consome o quantum do processo corrente; quando acabar, o escalonador
+  //   vai escolher outro processo (se houver outro pronto)
+  if (self->quantum > 0) self->quantum--;
+  // conta o tempo de execução do processo corrente, e avisa o algoritmo de
+  //   substituição de páginas
+  processo_t *proc = self->processo_corrente;
+  if (proc != NULL) proc->tempo++;
+  subst_tick(self->subst, proc == NULL ? 0 : proc->pid);
+  return ERR_OK;
+}
+
+// retorna true se a próxima interrupção do relógio vai acabar com o
+//   quantum do processo corrente (e talvez causar a troca de processo),
+//   ou se tem processo esperando o disco (que pode ter terminado)
+// sem processo corrente e sem espera pelo disco, não tem o que trocar
+static bool so_relogio_causa_troca(so_t *self)
+{
+  if (self->fila_disco.primeiro != NULL) return true;
+  return self->processo_corrente != NULL && self->quantum <= 1;
+}
+
+// E/S nos terminais
+
+// tenta realizar a leitura pedida pelo processo, no terminal dele
+// retorna false se o terminal não tem caractere para ler
+static bool so_tenta_ler(so_t *self, processo_t *proc)
+{
+  int disp = proc->terminal * 4;
+  int estado;
+  term_le(self->console, disp + 1, &estado);
+  if (estado == 0) return false;
+  term_le(self->console, disp, &proc->regs.A);
+  return true;
+}
+
+// tenta realizar a escrita pedida pelo processo (o caractere está no reg
+//   X), no terminal dele
+// retorna false se o terminal não pode escrever agora
+static bool so_tenta_escrever(so_t *self, processo_t *proc)
+{
+  int disp = proc->terminal * 4;
+  int estado;
+  term_le(self->console, disp + 3, &estado);
+  if (estado == 0) return false;
+  term_escr(self->console, disp + 2, proc->regs.X);
+  proc->regs.A = 0;
+  return true;
+}
+
+static err_t so_trata_irq_teclado(so_t *self)
+{
+  // algum terminal passou a ter caracteres para ler
+  // desliga o pedido de interrupção antes de olhar os terminais, para não
+  //   perder um caractere que chegue durante o tratamento
+  term_escr(self->console, CONSOLE_IRQ_TECLADO, 0);
+  for (int t = 0; t < N_TERM; t++) {
+    fila_t *fila = &self->fila_le[t];
+    while (fila->primeiro != NULL && so_tenta_ler(self, fila->primeiro)) {
+      so_acorda(self, fila->primeiro);
+    }
+  }
+  return ERR_OK;
+}
+
+static err_t so_trata_irq_tela(so_t *self)
+{
+  // algum terminal voltou a aceitar escrita
+  term_escr(self->console, CONSOLE_IRQ_TELA, 0);
+  for (int t = 0; t < N_TERM; t++) {
+    fila_t *fila = &self->fila_escr[t];
+    while (fila->primeiro != NULL && so_tenta_escrever(self, fila->primeiro)) {
+      so_acorda(self, fila->primeiro);
+    }
+  }
   return ERR_OK;
 }
 
 static err_t so_trata_irq_desconhecida(so_t *self, int irq)
 {
-  console_printf(self->console,
-      "SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
-  return ERR_CPU_PARADA;
+  LOG_ERRO(self->log, LOG_IRQ, LOG_MSG_IRQ_DESCONHECIDA, irq, irq);
+  return ERR_SO;
 }
 
 // Chamadas de sistema
 
-static void so_chamada_le(so_t *self);
-static void so_chamada_escr(so_t *self);
-static void so_chamada_cria_proc(so_t *self);
-static void so_chamada_mata_proc(so_t *self);
+static void so_chamada_le(so_t *self, processo_t *proc);
+static void so_chamada_escr(so_t *self, processo_t *proc);
+static void so_chamada_cria_proc(so_t *self, processo_t *proc);
+static void so_chamada_mata_proc(so_t *self, processo_t *proc);
+static void so_chamada_espera_proc(so_t *self, processo_t *proc);
 
 static err_t so_trata_chamada_sistema(so_t *self)
 {
-  // com processos, a identificação da chamada está no reg A no descritor
-  //   do processo
-  int id_chamada;
-  mem_le(self->mem, IRQ_END_A, &id_chamada);
-  console_printf(self->console,
-      "SO: chamada de sistema %d", id_chamada);
+  // a identificação da chamada está no reg A no descritor do processo
+  processo_t *proc = self->processo_corrente;
+  if (proc == NULL) {
+    LOG_ERRO(self->log, LOG_CHAMADA, LOG_MSG_CHAMADA_SEM_PROC);
+    return ERR_SO;
+  }
+  int id_chamada = proc->regs.A;
+  LOG_TRACO(self->log, LOG_CHAMADA, LOG_MSG_CHAMADA, id_chamada);
   switch (id_chamada) {
     case SO_LE:
-      so_chamada_le(self);
+      so_chamada_le(self, proc);
       break;
     case SO_ESCR:
-      so_chamada_escr(self);
+      so_chamada_escr(self, proc);
       break;
     case SO_CRIA_PROC:
-      so_chamada_cria_proc(self);
+      so_chamada_cria_proc(self, proc);
       break;
     case SO_MATA_PROC:
-      so_chamada_mata_proc(self);
+      so_chamada_mata_proc(self, proc);
+      break;
+    case SO_ESPERA_PROC:
+      so_chamada_espera_proc(self, proc);
       break;
     default:
-      console_printf(self->console,
-          "SO: chamada de sistema desconhecida (%d)", id_chamada);
-      return ERR_CPU_PARADA;
+      LOG_AVISO(self->log, LOG_CHAMADA, LOG_MSG_CHAMADA_DESCONHECIDA,
+                id_chamada, proc->pid);
+      so_mata_processo(self, proc);
   }
   return ERR_OK;
 }
 
-static void so_chamada_le(so_t *self)
-{
-  // implementação com espera ocupada
-  //   deveria bloquear o processo se leitura não disponível.
-  //   no caso de bloqueio do processo, a leitura (e desbloqueio) deverá
-  //   ser feita mais tarde, em tratamentos pendentes em outra interrupção,
-  //   ou diretamente em uma interrupção específica do dispositivo, se for
-  //   o caso
-  // implementação lendo direto do terminal A
-  //   deveria usar dispositivo corrente de entrada do processo
-  for (;;) {
-    int estado;
-    term_le(self->console, 1, &estado);
-    if (estado != 0) break;
-    // como não está saindo do SO, o laço do processador não tá rodando
-    // esta gambiarra faz o console andar
-    // com a implementação de bloqueio de processo, esta gambiarra não
-    //   deve mais existir.
-    console_tictac(self->console);
-    console_atualiza(self->console);
-  }
-  int dado;
-  term_le(self->console, 0, &dado);
-  // com processo, deveria escrever no reg A do processo
-  mem_escreve(self->mem, IRQ_END_A, dado);
-}
-
-static void so_chamada_escr(so_t *self)
-{
-  // implementação com espera ocupada
-  //   deveria bloquear o processo se dispositivo ocupado
-  // implementação escrevendo direto do terminal A
-  //   deveria usar dispositivo corrente de saída do processo
-  for (;;) {
-    int estado;
-    term_le(self->console, 3, &estado);
-    if (estado != 0) break;
-    // como não está saindo do SO, o laço do processador não tá rodando
-    // esta gambiarra faz o console andar
-    console_tictac(self->console);
-    console_atualiza(self->console);
-  }
-  int dado;
-  mem_le(self->mem, IRQ_END_X, &dado);
-  term_escr(self->console, 2, dado);
-  mem_escreve(self->mem, IRQ_END_A, 0);
-}
-
-static void so_chamada_cria_proc(so_t *self)
-{
-  // ainda sem suporte a processos, carrega programa e passa a executar ele
-  // quem chamou o sistema não vai mais ser executado, coitado!
+// as chamadas de E/S são realizadas imediatamente se o terminal estiver
+//   pronto (e não tiver outro processo esperando por ele); senão, o
+//   processo é bloqueado na fila do terminal, e a operação é realizada no
+//   tratamento da interrupção do teclado ou da tela
+static void so_chamada_le(so_t *self, processo_t *proc)
+{
+  fila_t *fila = &self->fila_le[proc->terminal];
+  if (fila->primeiro == NULL && so_tenta_ler(self, proc)) return;
+  so_espera_evento(self, proc, fila);
+}
 
+static void so_chamada_escr(so_t *self, processo_t *proc)
+{
+  fila_t *fila = &self->fila_escr[proc->terminal];
+  if (fila->primeiro == NULL && so_tenta_escrever(self, proc)) return;
+  so_espera_evento(self, proc, fila);
+}
+
+static void so_chamada_cria_proc(so_t *self, processo_t *proc)
+{
   // em X está o endereço onde está o nome do arquivo
-  int ender_proc;
-  // deveria ler o X do descritor do processo criador
-  if (mem_le(self->mem, IRQ_END_X, &ender_proc) == ERR_OK) {
-    char nome[100];
-    if (so_copia_str_do_processo(self, 100, nome, ender_proc)) {
-      int ender_carga = so_carrega_programa(self, nome);
-      // o endereço de carga é endereço virtual, deve ser 0
-      if (ender_carga >= 0) {
-        // deveria escrever no PC do descritor do processo criado
-        mem_escreve(self->mem, IRQ_END_PC, ender_carga);
-        return;
+  char nome[100];
+  acesso_t acesso = so_copia_str_do_processo(self, 100, nome, proc->regs.X,
+                                             proc);
+  if (acesso == ACESSO_ADIADO) {
+    // o processo está esperando o disco; a chamada vai ser refeita quando
+    //   ele voltar a executar (CHAMAS não tem argumento, está no endereço
+    //   anterior ao PC), e A ainda tem o número da chamada
+    proc->regs.PC--;
+    return;
+  }
+  if (acesso == ACESSO_OK) {
+    processo_t *novo = so_cria_processo(self, nome);
+    if (novo != NULL) {
+      proc->regs.A = novo->pid;
+      return;
+    }
+  }
+  proc->regs.A = -1;
+}
+
+static void so_chamada_mata_proc(so_t *self, processo_t *proc)
+{
+  // em X está o pid do processo a matar, 0 para o próprio processo
+  processo_t *vitima = proc;
+  if (proc->regs.X != 0) {
+    vitima = so_busca_processo(self, proc->regs.X);
+  }
+  if (vitima == NULL) {
+    proc->regs.A = -1;
+    return;
+  }
+  proc->regs.A = 0;
+  so_mata_processo(self, vitima);
+}
+
+static void so_chamada_espera_proc(so_t *self, processo_t *proc)
+{
+  // em X está o pid do processo a esperar
+  int pid = proc->regs.X;
+  if (pid == proc->pid || so_busca_processo(self, pid) == NULL) {
+    proc->regs.A = -1;
+    return;
+  }
+  proc->pid_esperado = pid;
+  so_espera_evento(self, proc, &self->fila_espera);
+}
+
+
+// Processos
+
+// cria um processo para executar o programa do arquivo dado
+// retorna o descritor do processo criado, ou NULL se não for possível
+static processo_t *so_cria_processo(so_t *self, char *nome_do_executavel)
+{
+  processo_t *proc = NULL;
+  for (int i = 0; i < MAX_PROCESSOS; i++) {
+    if (self->processos[i].estado == livre) {
+      proc = &self->processos[i];
+      break;
+    }
+  }
+  if (proc == NULL) {
+    LOG_AVISO(self->log, LOG_PROC, LOG_MSG_TABELA_CHEIA);
+    return NULL;
+  }
+  int ender = so_carrega_programa(self, proc, nome_do_executavel);
+  if (ender < 0) return NULL;
+  // a tabela já é criada com espaço para todas as páginas do programa
+  proc->tabpag = tabpag_cria(self->tipo_tabpag, mmu_tam_pagina(self->mmu),
+                             proc->pagina_ini + proc->n_paginas);
+  if (proc->tabpag == NULL) {
+    so_libera_blocos_sec(self, proc->bloco_sec, proc->n_paginas);
+    return NULL;
+  }
+  proc->simbolos = so_simbolos_do_programa(self, nome_do_executavel);
+  // para o perfil de execução, se houver
+  cpu_nomeia_tabpag(self->cpu, proc->tabpag, nome_do_executavel,
+                    proc->simbolos);
+  proc->pid = self->proximo_pid++;
+  proc->estado = pronto;
+  proc->tempo = 0;
+  proc->n_faltas = 0;
+  proc->quadros = QUADROS_LISTA_VAZIA;
+  // começa com os registradores zerados, exceto o PC
+  proc->regs.PC = ender;
+  proc->regs.A = 0;
+  proc->regs.X = 0;
+  proc->regs.erro = ERR_OK;
+  proc->regs.complemento = 0;
+  proc->regs.modo = usuario;
+  proc->terminal = (proc->pid - 1) % N_TERM;
+  proc->fila = NULL;
+  proc->prox_na_fila = NULL;
+  proc->tem_vaga = false;
+  proc->n_copiado = 0;
+  so_ocupa_vaga(self, proc);
+  LOG_INFO_STR(self->log, LOG_PROC, LOG_MSG_PROC_CRIADO, nome_do_executavel,
+               proc->pid);
+  return proc;
+}
+
+// mata um processo, libera a memória dele e desbloqueia os processos que
+//   esperam por ele
+static void so_mata_processo(so_t *self, processo_t *proc)
+{
+  LOG_INFO(self->log, LOG_PROC, LOG_MSG_PROC_MORREU, proc->pid,
+           proc->n_faltas);
+  if (proc->fila != NULL) {
+    so_desbloqueia(self, proc);
+  }
+  so_libera_vaga(self, proc);
+  processo_t *p = self->fila_espera.primeiro;
+  while (p != NULL) {
+    processo_t *prox = p->prox_na_fila;
+    if (p->pid_esperado == proc->pid) {
+      p->regs.A = 0;
+      so_acorda(self, p);
+    }
+    p = prox;
+  }
+  if (proc == self->processo_corrente) {
+    // a tabela dele está na MMU
+    mmu_define_tabpag(self->mmu, NULL);
+    self->processo_corrente = NULL;
+  }
+  so_libera_memoria(self, proc);
+  tabpag_destroi(proc->tabpag);
+  proc->tabpag = NULL;
+  proc->estado = livre;
+}
+
+// bloqueia o processo, colocando-o no final da fila
+static void so_bloqueia(so_t *self, processo_t *proc, fila_t *fila)
+{
+  proc->estado = bloqueado;
+  proc->fila = fila;
+  proc->prox_na_fila = NULL;
+  if (fila->ultimo == NULL) {
+    fila->primeiro = proc;
+  } else {
+    fila->ultimo->prox_na_fila = proc;
+  }
+  fila->ultimo = proc;
+}
+
+// desbloqueia o processo, tirando-o da fila onde está (em qualquer posição)
+static void so_desbloqueia(so_t *self, processo_t *proc)
+{
+  fila_t *fila = proc->fila;
+  processo_t *ant = NULL;
+  processo_t *p = fila->primeiro;
+  while (p != proc) {
+    ant = p;
+    p = p->prox_na_fila;
+  }
+  if (ant == NULL) {
+    fila->primeiro = proc->prox_na_fila;
+  } else {
+    ant->prox_na_fila = proc->prox_na_fila;
+  }
+  if (fila->ultimo == proc) {
+    fila->ultimo = ant;
+  }
+  proc->fila = NULL;
+  proc->prox_na_fila = NULL;
+  proc->estado = pronto;
+}
+
+// bloqueia o processo esperando um evento que pode demorar, liberando a
+//   vaga dele na memória
+static void so_espera_evento(so_t *self, processo_t *proc, fila_t *fila)
+{
+  so_libera_vaga(self, proc);
+  so_bloqueia(self, proc, fila);
+}
+
+// desbloqueia o processo que esperava um evento (ver so_espera_evento);
+//   ele precisa de novo de uma vaga na memória para executar
+static void so_acorda(so_t *self, processo_t *proc)
+{
+  so_desbloqueia(self, proc);
+  so_ocupa_vaga(self, proc);
+}
+
+// dá ao processo pronto uma vaga na memória, ou bloqueia ele na fila da
+//   memória se não tiver vaga
+static void so_ocupa_vaga(so_t *self, processo_t *proc)
+{
+  if (self->n_vagas_ocupadas < self->n_vagas) {
+    proc->tem_vaga = true;
+    self->n_vagas_ocupadas++;
+  } else {
+    so_bloqueia(self, proc, &self->fila_memoria);
+  }
+}
+
+// libera a vaga do processo na memória (se ele tiver), passando-a para o
+//   primeiro que estiver esperando
+// os quadros do processo não são liberados, mas as páginas dele passam a
+//   ser tiradas da memória pela substituição, já que ele não as acessa
+static void so_libera_vaga(so_t *self, processo_t *proc)
+{
+  if (!proc->tem_vaga) return;
+  proc->tem_vaga = false;
+  self->n_vagas_ocupadas--;
+  processo_t *prox = self->fila_memoria.primeiro;
+  if (prox != NULL) {
+    so_desbloqueia(self, prox);
+    so_ocupa_vaga(self, prox);
+  }
+}
+
+// retorna o descritor do processo com o pid dado, ou NULL se não existir
+static processo_t *so_busca_processo(so_t *self, int pid)
+{
+  for (int i = 0; i < MAX_PROCESSOS; i++) {
+    processo_t *proc = &self->processos[i];
+    if (proc->estado != livre && proc->pid == pid) return proc;
+  }
+  return NULL;
+}
+
+
+// Memória
+
+// aloca 'n' blocos consecutivos da memória secundária
+// retorna o primeiro, ou -1 se não tiver
+static int so_aloca_blocos_sec(so_t *self, int n)
+{
+  int livres = 0;
+  for (int bloco = 0; bloco < self->n_blocos; bloco++) {
+    livres = self->bloco_ocupado[bloco] ? 0 : livres + 1;
+    if (livres == n) {
+      int primeiro = bloco - n + 1;
+      for (int b = primeiro; b <= bloco; b++) {
+        self->bloco_ocupado[b] = true;
       }
+      return primeiro;
     }
   }
-  // deveria escrever -1 (se erro) ou o PID do processo criado (se OK) no reg A
-  //   do processo que pediu a criação
-  mem_escreve(self->mem, IRQ_END_A, -1);
+  return -1;
 }
 
-static void so_chamada_mata_proc(so_t *self)
+static void so_libera_blocos_sec(so_t *self, int primeiro, int n)
 {
-  // ainda sem suporte a processos, retorna erro -1
-  console_printf(self->console, "SO: SO_MATA_PROC não implementada");
-  mem_escreve(self->mem, IRQ_END_A, -1);
+  for (int b = primeiro; b < primeiro + n; b++) {
+    self->bloco_ocupado[b] = false;
+  }
 }
 
+// retorna o endereço da memória secundária onde está a página do processo
+static int so_end_sec(so_t *self, processo_t *proc, int pagina)
+{
+  int bloco = proc->bloco_sec + pagina - proc->pagina_ini;
+  return bloco * mmu_tam_pagina(self->mmu);
+}
 
-// carrega o programa na memória
+// carrega o programa na memória secundária, em blocos consecutivos
+// a tabela de páginas do processo fica vazia, as páginas vão para a
+//   memória principal por demanda (ver so_trata_falta_de_pagina)
 // retorna o endereço de carga ou -1
-// está simplesmente lendo para o próximo quadro que nunca foi ocupado,
-//   nem testa se tem memória disponível
-// com memória virtual, a forma mais simples de implementar a carga
-//   de um programa é carregá-lo para a memória secundária, e mapear
-//   todas as páginas da tabela de páginas como inválidas. assim, 
-//   as páginas serão colocadas na memória principal por demanda.
-//   para simplificar ainda mais, a memória secundária pode ser alocada
-//   da forma como a principal está sendo alocada aqui (sem reuso)
-static int so_carrega_programa(so_t *self, char *nome_do_executavel)
+static int so_carrega_programa(so_t *self, processo_t *proc,
+                               char *nome_do_executavel)
 {
   // programa para executar na nossa CPU
   programa_t *prog = prog_cria(nome_do_executavel);
   if (prog == NULL) {
-    console_printf(self->console,
-        "Erro na leitura do programa '%s'\n", nome_do_executavel);
+    LOG_AVISO_STR(self->log, LOG_MEM, LOG_MSG_ERRO_LEITURA_PROG,
+                  nome_do_executavel);
     return -1;
   }
 
+  int tam_pagina = mmu_tam_pagina(self->mmu);
   int end_virt_ini = prog_end_carga(prog);
   int end_virt_fim = end_virt_ini + prog_tamanho(prog) - 1;
-  int pagina_ini = end_virt_ini / TAM_PAGINA;
-  int pagina_fim = end_virt_fim / TAM_PAGINA;
-  int quadro_ini = self->quadro_livre;
-  // mapeia as páginas nos quadros
-  int quadro = quadro_ini;
-  for (int pagina = pagina_ini; pagina <= pagina_fim; pagina++) {
-    tabpag_define_quadro(self->tabpag, pagina, quadro);
-    quadro++;
-  }
-  self->quadro_livre = quadro;
-
-  // carrega o programa na memória principal
-  int end_fis_ini = quadro_ini * TAM_PAGINA;
-  int end_fis = end_fis_ini;
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++) {
-    if (mem_escreve(self->mem, end_fis, prog_dado(prog, end_virt)) != ERR_OK) {
-      console_printf(self->console,
-          "Erro na carga da memória, end virt %d fís %d\n", end_virt, end_fis);
-      return -1;
-    }
-    end_fis++;
+  int pagina_ini = end_virt_ini / tam_pagina;
+  int pagina_fim = end_virt_fim / tam_pagina;
+  int n_paginas = pagina_fim - pagina_ini + 1;
+  int bloco = so_aloca_blocos_sec(self, n_paginas);
+  if (bloco < 0) {
+    LOG_AVISO(self->log, LOG_MEM, LOG_MSG_SEM_MEMORIA_SEC, n_paginas);
+    prog_destroi(prog);
+    return -1;
+  }
+  proc->pagina_ini = pagina_ini;
+  proc->n_paginas = n_paginas;
+  proc->bloco_sec = bloco;
+
+  // o programa fica todo em seguida na memória secundária, basta uma cópia
+  int end_sec = so_end_sec(self, proc, pagina_ini)
+                + end_virt_ini - pagina_ini * tam_pagina;
+  if (mem_escreve_bloco(self->mem_sec, end_sec, prog_tamanho(prog),
+                        prog_dados(prog)) != ERR_OK) {
+    LOG_ERRO(self->log, LOG_MEM, LOG_MSG_ERRO_CARGA, end_virt_ini, end_sec);
+    so_libera_blocos_sec(self, bloco, n_paginas);
+    prog_destroi(prog);
+    return -1;
   }
   prog_destroi(prog);
-  console_printf(self->console,
-      "SO: carga de '%s' em V%d-%d F%d-%d", nome_do_executavel,
-                 end_virt_ini, end_virt_fim, end_fis_ini, end_fis - 1);
+  LOG_INFO_STR(self->log, LOG_MEM, LOG_MSG_CARGA, nome_do_executavel,
+               end_virt_ini, end_virt_fim, end_sec,
+               end_sec + end_virt_fim - end_virt_ini);
   return end_virt_ini;
 }
 
-// copia uma string da memória do processo para o vetor str.
-// retorna false se erro (string maior que vetor, valor não ascii na memória,
-//   erro de acesso à memória)
-// o endereço é um endereço virtual de um processo.
-// Com processos e memória virtual implementados, esta função deve também
-//   receber o processo como argumento
-// Cada valor do espaço de endereçamento do processo pode estar em memória
-//   principal ou secundária
-// O endereço é um endereço virtual de um processo.
-// Com processos e memória virtual implementados, esta função deve também
-//   receber o processo como argumento
-// Com memória virtual, cada valor do espaço de endereçamento do processo
-//   pode estar em memória principal ou secundária
-static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
-                                     int end_virt/*, processo*/)
+// libera o quadro, tirando a página que está nele da tabela de páginas do
+//   dono; se 'salva' e a página tiver sido alterada, copia ela para a
+//   memória secundária
+// retorna true se copiou
+static bool so_libera_quadro(so_t *self, int quadro, bool salva)
+{
+  int tam_pagina = mmu_tam_pagina(self->mmu);
+  tabpag_t *tabpag = quadros_tabpag(self->quadros, quadro);
+  int pagina = quadros_pagina(self->quadros, quadro);
+  bool copiou = false;
+  if (salva && tabpag_bit_alteracao(tabpag, pagina)) {
+    processo_t *dono = so_busca_processo(self,
+                                         quadros_pid(self->quadros, quadro));
+    mem_copia(self->mem_sec, so_end_sec(self, dono, pagina),
+              self->mem, quadro * tam_pagina, tam_pagina);
+    copiou = true;
+  }
+  tabpag_define_quadro(tabpag, pagina, -1);
+  subst_notifica_liberacao(self->subst, quadro);
+  quadros_libera(self->quadros, quadro);
+  return copiou;
+}
+
+// bloqueia o processo até o disco fazer mais 'n' transferências de página
+// se o processo já estiver esperando o disco, continua, até o fim destas
+static void so_espera_disco(so_t *self, processo_t *proc, int n)
+{
+  int agora = rel_agora(self->relogio);
+  if (self->disco_livre < agora) self->disco_livre = agora;
+  self->disco_livre += n * TEMPO_DISCO;
+  proc->fim_espera_disco = self->disco_livre;
+  if (proc->estado != bloqueado) {
+    so_bloqueia(self, proc, &self->fila_disco);
+  }
+}
+
+// atende uma falta de página do processo, no acesso ao endereço virtual
+//   'end_virt': coloca a página num quadro da memória principal (liberando
+//   um, se necessário) e bloqueia o processo pelo tempo das transferências
+// se todos os quadros estiverem em transferência, o processo espera o fim
+//   das transferências já pedidas, sem a página ser trazida, e retorna
+//   ACESSO_ADIADO: o acesso que causou a falta deve ser refeito quando o
+//   processo voltar a executar
+// retorna ACESSO_INVALIDO se o endereço não pertence ao processo (ou não
+//   tem quadro que possa ser usado)
+static acesso_t so_trata_falta_de_pagina(so_t *self, processo_t *proc,
+                                         int end_virt)
+{
+  int tam_pagina = mmu_tam_pagina(self->mmu);
+  if (end_virt < 0) return ACESSO_INVALIDO;
+  int pagina = end_virt / tam_pagina;
+  if (pagina < proc->pagina_ini
+      || pagina >= proc->pagina_ini + proc->n_paginas) {
+    return ACESSO_INVALIDO;
+  }
+  int transferencias = 1;
+  if (quadros_num_livres(self->quadros) == 0) {
+    int vitima = subst_escolhe_vitima(self->subst);
+    if (vitima == -1) {
+      if (quadros_num_em_transferencia(self->quadros) == 0) {
+        return ACESSO_INVALIDO;
+      }
+      so_espera_disco(self, proc, 0);
+      return ACESSO_ADIADO;
+    }
+    if (so_libera_quadro(self, vitima, true)) transferencias++;
+  }
+  int quadro = quadros_aloca(self->quadros, proc->pid, proc->tabpag, pagina,
+                             &proc->quadros);
+  mem_copia(self->mem, quadro * tam_pagina,
+            self->mem_sec, so_end_sec(self, proc, pagina), tam_pagina);
+  tabpag_define_quadro(proc->tabpag, pagina, quadro);
+  // a página conta como acessada (pelo acesso que causou a falta), senão
+  //   ela poderia ser escolhida para sair antes de o processo voltar a
+  //   executar e acessá-la
+  tabpag_marca_bit_acesso(proc->tabpag, pagina, false);
+  subst_notifica_carga(self->subst, quadro);
+  quadros_define_em_transferencia(self->quadros, quadro, true);
+  proc->n_faltas++;
+  self->n_faltas++;
+  LOG_TRACO(self->log, LOG_MEM, LOG_MSG_FALTA_PAGINA, pagina, proc->pid,
+            quadro);
+  so_espera_disco(self, proc, transferencias);
+  return ACESSO_OK;
+}
+
+// termina as transferências para os quadros do processo, que passam a
+//   poder ser substituídos
+static void so_fim_das_transferencias(so_t *self, processo_t *proc)
+{
+  // os quadros alocados por último ficam no início da lista, os que estão
+  //   em transferência são os primeiros
+  int quadro = proc->quadros;
+  while (quadro != QUADROS_LISTA_VAZIA
+         && quadros_em_transferencia(self->quadros, quadro)) {
+    quadros_define_em_transferencia(self->quadros, quadro, false);
+    quadro = quadros_proximo_do_dono(self->quadros, quadro);
+  }
+}
+
+// libera os quadros e a memória secundária ocupados pelo processo
+static void so_libera_memoria(so_t *self, processo_t *proc)
+{
+  while (proc->quadros != QUADROS_LISTA_VAZIA) {
+    so_libera_quadro(self, proc->quadros, false);
+  }
+  so_libera_blocos_sec(self, proc->bloco_sec, proc->n_paginas);
+}
+
+// retorna o tempo de execução do processo 'pid' (para a substituição de
+//   páginas)
+static int so_tempo_do_processo(void *arg, int pid)
+{
+  so_t *self = arg;
+  processo_t *proc = so_busca_processo(self, pid);
+  return proc == NULL ? 0 : proc->tempo;
+}
+
+// retorna o mapa de símbolos do programa, lido do arquivo com o mesmo nome
+//   do executável mas com extensão .sym (gerado pelo montador)
+// retorna NULL se o arquivo não existe
+static simbolos_t *so_simbolos_do_programa(so_t *self,
+                                           char *nome_do_executavel)
 {
-  for (int indice_str = 0; indice_str < tam; indice_str++) {
+  for (int i = 0; i < self->n_programas; i++) {
+    if (strcmp(self->programas[i].nome, nome_do_executavel) == 0) {
+      return self->programas[i].simbolos;
+    }
+  }
+  if (self->n_programas >= MAX_PROGRAMAS) return NULL;
+  // troca a extensão .maq (se tiver) por .sym
+  char nome_sym[110];
+  strncpy(nome_sym, nome_do_executavel, 99);
+  nome_sym[99] = '\0';
+  char *ext = strrchr(nome_sym, '.');
+  if (ext != NULL && strcmp(ext, ".maq") == 0) *ext = '\0';
+  strcat(nome_sym, ".sym");
+  programa_simb_t *prog = &self->programas[self->n_programas++];
+  strncpy(prog->nome, nome_do_executavel, 99);
+  prog->nome[99] = '\0';
+  prog->simbolos = simb_cria(nome_sym);
+  return prog->simbolos;
+}
+
+// estado da cópia de uma string, para so__copia_trecho
+typedef struct {
+  mem_t *mem;
+  char *str;
+  int pos;           // próxima posição de str a preencher
+  bool terminou;     // já copiou o 0 do final
+  bool invalida;     // encontrou um valor que não é caractere
+} copia_str_t;
+
+// copia para a string um trecho traduzido pela MMU (ver mmu_traduz_faixa)
+// para no final da string ou num valor inválido
+static bool so__copia_trecho(void *arg, int end_virt, int end_fis, int n)
+{
+  copia_str_t *copia = arg;
+  for (int i = 0; i < n; i++) {
     int caractere;
-    // não tem memória virtual implementada, posso usar a mmu para traduzir
-    //   os endereços e acessar a memória
-    if (mmu_le(self->mmu, end_virt + indice_str, &caractere, usuario) != ERR_OK) {
+    if (mem_le(copia->mem, end_fis + i, &caractere) != ERR_OK
+        || caractere < 0 || caractere > 255) {
+      copia->invalida = true;
       return false;
     }
-    if (caractere < 0 || caractere > 255) {
+    copia->str[copia->pos++] = caractere;
+    if (caractere == 0) {
+      copia->terminou = true;
       return false;
     }
-    str[indice_str] = caractere;
-    if (caractere == 0) {
-      return true;
+  }
+  return true;
+}
+
+// copia uma string da memória do processo para o vetor str.
+// retorna ACESSO_INVALIDO se erro (string maior que vetor, valor não ascii
+//   na memória, erro de acesso à memória), ACESSO_ADIADO se uma página não
+//   pôde ser trazida para a memória principal (ver so_trata_falta_de_pagina)
+// a cópia adiada é guardada no descritor do processo, e continua de onde
+//   parou na próxima chamada (com a mesma string, quando o processo refizer
+//   a chamada de sistema)
+// O endereço é um endereço virtual do processo, traduzido pela tabela de
+//   páginas dele (não pela tabela que está na MMU, que pode ser a de outro
+//   processo); cada página é traduzida uma vez só
+// Com memória virtual, cada valor do espaço de endereçamento do processo
+//   pode estar em memória principal ou secundária
+static acesso_t so_copia_str_do_processo(so_t *self, int tam, char str[tam],
+                                         int end_virt, processo_t *proc)
+{
+  assert(tam <= sizeof(proc->str_copiada));
+  // recupera o que já tinha sido copiado, se a cópia foi adiada
+  copia_str_t copia = { self->mem, str, proc->n_copiado, false, false };
+  memcpy(str, proc->str_copiada, proc->n_copiado);
+  proc->n_copiado = 0;
+  int end = end_virt + copia.pos;
+  int end_erro;
+  while (mmu_traduz_faixa(self->mmu, proc->tabpag, end, tam - copia.pos,
+                          MMU_MARCA_ACESSO, so__copia_trecho, &copia,
+                          &end_erro) != ERR_OK) {
+    // a página pode não estar na memória principal: é trazida (o processo
+    //   fica bloqueado pelo tempo da transferência, mas a cópia é feita
+    //   agora), e a cópia continua dela
+    acesso_t acesso = so_trata_falta_de_pagina(self, proc, end_erro);
+    if (acesso == ACESSO_ADIADO) {
+      memcpy(proc->str_copiada, str, copia.pos);
+      proc->n_copiado = copia.pos;
     }
+    if (acesso != ACESSO_OK) return acesso;
+    end = end_erro;
   }
-  // estourou o tamanho de str
-  return false;
+  // se não terminou, estourou o tamanho de str (ou tem valor inválido)
+  if (!copia.terminou) return ACESSO_INVALIDO;
+  return ACESSO_OK;
 }
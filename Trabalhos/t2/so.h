@@ -12,11 +12,36 @@ typedef struct so_t so_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
-
-so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu,
-              console_t *console, relogio_t *relogio);
+#include "log.h"
+#include "subst.h"
+
+// as mensagens do SO são registradas em 'log'
+// 'mem_sec' é a memória secundária, onde ficam as páginas dos processos
+//   que não estão na memória principal ('mem')
+so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_sec, mmu_t *mmu,
+              console_t *console, relogio_t *relogio, log_t *log);
 void so_destroi(so_t *self);
 
+// define o programa a ser executado pelo processo inicial, criado pelo SO
+//   na inicialização (o padrão é "init.maq")
+// deve ser chamada antes da CPU começar a executar
+void so_define_programa_inicial(so_t *self, char *nome);
+
+// define o algoritmo de substituição de páginas (o padrão é fifo) e, para o
+//   wsclock, o tamanho da janela do conjunto de trabalho, em interrupções
+//   do relógio (ver subst.h)
+// deve ser chamada antes da CPU começar a executar
+// retorna false em caso de erro (e o algoritmo não é alterado)
+bool so_define_substituicao(so_t *self, subst_alg_t alg, int tau);
+
+// define a organização das tabelas de páginas dos processos (o padrão é
+//   linear; ver tabpag.h)
+// deve ser chamada antes da CPU começar a executar
+void so_define_tipo_tabpag(so_t *self, tabpag_tipo_t tipo);
+
+// retorna o número de faltas de página atendidas desde o início
+long so_num_faltas_de_pagina(so_t *self);
+
 // Chamadas de sistema
 // Uma chamada de sistema é realizada colocando a identificação da
 //   chamada (um dos valores abaixo) no registrador A e executando a
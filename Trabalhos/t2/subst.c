@@ -0,0 +1,425 @@
+#include "subst.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// bit mais significativo do contador do envelhecimento
+#define BIT_RECENTE 0x80000000u
+
+// bits colhidos da tabela de páginas de um processo
+typedef struct {
+  tabpag_t *tabpag;
+  uint64_t *acessadas;
+  uint64_t *alteradas;
+  int n_palavras;     // tamanho alocado para os mapas
+} colheita_t;
+
+// as operações que variam com o algoritmo
+typedef struct {
+  char *nome;
+  void (*tick)(subst_t *self, int pid);
+  int (*escolhe_vitima)(subst_t *self);
+} subst_ops_t;
+
+struct subst_t {
+  quadros_t *quadros;
+  int n_quadros;
+  subst_ops_t *ops;
+  // fila dos quadros ocupados, na ordem em que receberam a página
+  //   (fifo e segunda chance); -1 é o fim da fila
+  int *prox;
+  int *ant;
+  int primeiro;
+  int ultimo;
+  // próximo quadro a examinar (relógio e wsclock)
+  int ponteiro;
+  // contador de cada quadro (envelhecimento)
+  unsigned *contador;
+  // tempo do dono no último acesso à página de cada quadro (wsclock)
+  int *t_uso;
+  int tau;
+  subst_f_tempo_t f_tempo;
+  void *arg_tempo;
+  // bits de acesso e alteração das páginas dos quadros, colhidos das
+  //   tabelas de páginas no início de cada escolha ou tick (uma colheita
+  //   por tabela); colheita_do_quadro é o índice em colheitas
+  colheita_t *colheitas;
+  int n_colheitas;
+  int max_colheitas;
+  int *colheita_do_quadro;
+};
+
+
+// acesso aos bits da página que está em um quadro
+// os bits são colhidos de uma vez (subst__colhe) e consultados na colheita,
+//   em vez de uma chamada à tabela de páginas para cada página
+
+static bool subst__ocupado(subst_t *self, int quadro)
+{
+  return quadros_tabpag(self->quadros, quadro) != NULL;
+}
+
+// os quadros fixos e os em transferência não podem ser escolhidos
+static bool subst__substituivel(subst_t *self, int quadro)
+{
+  return quadros_substituivel(self->quadros, quadro);
+}
+
+// retorna a colheita para a tabela 'tabpag', criando se necessário
+static colheita_t *subst__colheita(subst_t *self, tabpag_t *tabpag)
+{
+  for (int i = 0; i < self->n_colheitas; i++) {
+    if (self->colheitas[i].tabpag == tabpag) return &self->colheitas[i];
+  }
+  if (self->n_colheitas == self->max_colheitas) {
+    int max = self->max_colheitas == 0 ? 4 : 2 * self->max_colheitas;
+    self->colheitas = realloc(self->colheitas, max * sizeof(colheita_t));
+    assert(self->colheitas != NULL);
+    for (int i = self->max_colheitas; i < max; i++) {
+      self->colheitas[i].acessadas = NULL;
+      self->colheitas[i].alteradas = NULL;
+      self->colheitas[i].n_palavras = 0;
+    }
+    self->max_colheitas = max;
+  }
+  colheita_t *col = &self->colheitas[self->n_colheitas++];
+  col->tabpag = tabpag;
+  int palavras = (tabpag_num_paginas(tabpag) + 63) / 64;
+  if (palavras > col->n_palavras) {
+    col->acessadas = realloc(col->acessadas, palavras * sizeof(uint64_t));
+    col->alteradas = realloc(col->alteradas, palavras * sizeof(uint64_t));
+    assert(col->acessadas != NULL && col->alteradas != NULL);
+    col->n_palavras = palavras;
+  }
+  tabpag_colhe_bits(tabpag, col->acessadas, col->alteradas, false);
+  return col;
+}
+
+// colhe os bits das tabelas de páginas dos quadros do processo 'pid' (de
+//   todos os quadros ocupados se 'pid' for 0)
+// se 'zera' for true, os bits de acesso colhidos são zerados nas tabelas
+//   (não na colheita)
+static void subst__colhe(subst_t *self, int pid, bool zera)
+{
+  self->n_colheitas = 0;
+  for (int quadro = 0; quadro < self->n_quadros; quadro++) {
+    tabpag_t *tabpag = quadros_tabpag(self->quadros, quadro);
+    int dono = quadros_pid(self->quadros, quadro);
+    if (tabpag == NULL || (pid != 0 && dono != pid)) {
+      self->colheita_do_quadro[quadro] = -1;
+      continue;
+    }
+    colheita_t *col = subst__colheita(self, tabpag);
+    self->colheita_do_quadro[quadro] = col - self->colheitas;
+  }
+  if (zera) {
+    for (int i = 0; i < self->n_colheitas; i++) {
+      tabpag_colhe_bits(self->colheitas[i].tabpag, NULL, NULL, true);
+    }
+  }
+}
+
+static bool subst__bit(uint64_t *mapa, int pagina)
+{
+  return (mapa[pagina / 64] >> (pagina % 64)) & 1;
+}
+
+static bool subst__acessada(subst_t *self, int quadro)
+{
+  int i = self->colheita_do_quadro[quadro];
+  if (i == -1) return false;
+  return subst__bit(self->colheitas[i].acessadas,
+                    quadros_pagina(self->quadros, quadro));
+}
+
+static bool subst__alterada(subst_t *self, int quadro)
+{
+  int i = self->colheita_do_quadro[quadro];
+  if (i == -1) return false;
+  return subst__bit(self->colheitas[i].alteradas,
+                    quadros_pagina(self->quadros, quadro));
+}
+
+// zera o bit de acesso da página na tabela e na colheita
+static void subst__zera_acesso(subst_t *self, int quadro)
+{
+  int pagina = quadros_pagina(self->quadros, quadro);
+  tabpag_zera_bit_acesso(quadros_tabpag(self->quadros, quadro), pagina);
+  int i = self->colheita_do_quadro[quadro];
+  if (i == -1) return;
+  self->colheitas[i].acessadas[pagina / 64] &= ~((uint64_t)1 << (pagina % 64));
+}
+
+// retorna o tempo de execução do dono do quadro
+static int subst__tempo_do_dono(subst_t *self, int quadro)
+{
+  if (self->f_tempo == NULL) return 0;
+  return self->f_tempo(self->arg_tempo, quadros_pid(self->quadros, quadro));
+}
+
+
+// fila dos quadros em ordem de carga
+
+static void subst__insere_na_fila(subst_t *self, int quadro)
+{
+  self->prox[quadro] = -1;
+  self->ant[quadro] = self->ultimo;
+  if (self->ultimo == -1) {
+    self->primeiro = quadro;
+  } else {
+    self->prox[self->ultimo] = quadro;
+  }
+  self->ultimo = quadro;
+}
+
+static void subst__remove_da_fila(subst_t *self, int quadro)
+{
+  int prox = self->prox[quadro];
+  int ant = self->ant[quadro];
+  if (ant == -1) {
+    self->primeiro = prox;
+  } else {
+    self->prox[ant] = prox;
+  }
+  if (prox == -1) {
+    self->ultimo = ant;
+  } else {
+    self->ant[prox] = ant;
+  }
+}
+
+
+// algoritmos
+
+static void subst__tick_nada(subst_t *self, int pid)
+{
+}
+
+static int subst__fifo(subst_t *self)
+{
+  for (int quadro = self->primeiro; quadro != -1; quadro = self->prox[quadro]) {
+    if (subst__substituivel(self, quadro)) return quadro;
+  }
+  return -1;
+}
+
+static int subst__segunda_chance(subst_t *self)
+{
+  // no pior caso, todas as páginas foram acessadas e vão para o final da
+  //   fila; aí a primeira volta a ser a primeira, sem o bit de acesso
+  // as que não podem ser escolhidas vão para o final da fila sem perder o
+  //   bit
+  subst__colhe(self, 0, false);
+  for (int n = 0; n <= 2 * self->n_quadros; n++) {
+    int quadro = self->primeiro;
+    if (quadro == -1) return -1;
+    if (subst__substituivel(self, quadro)) {
+      if (!subst__acessada(self, quadro)) return quadro;
+      subst__zera_acesso(self, quadro);
+    }
+    subst__remove_da_fila(self, quadro);
+    subst__insere_na_fila(self, quadro);
+  }
+  return subst__fifo(self);
+}
+
+// retorna o quadro apontado e avança o ponteiro
+static int subst__avanca_ponteiro(subst_t *self)
+{
+  int quadro = self->ponteiro;
+  self->ponteiro = (self->ponteiro + 1) % self->n_quadros;
+  return quadro;
+}
+
+static int subst__relogio(subst_t *self)
+{
+  // na primeira volta, desliga o bit de acesso das páginas acessadas; na
+  //   segunda, escolhe com certeza (se tiver algum quadro ocupado)
+  subst__colhe(self, 0, false);
+  for (int n = 0; n < 2 * self->n_quadros; n++) {
+    int quadro = subst__avanca_ponteiro(self);
+    if (!subst__substituivel(self, quadro)) continue;
+    if (!subst__acessada(self, quadro)) return quadro;
+    subst__zera_acesso(self, quadro);
+  }
+  return -1;
+}
+
+static void subst__tick_envelhecimento(subst_t *self, int pid)
+{
+  subst__colhe(self, 0, true);
+  for (int quadro = 0; quadro < self->n_quadros; quadro++) {
+    if (!subst__ocupado(self, quadro)) continue;
+    self->contador[quadro] >>= 1;
+    if (subst__acessada(self, quadro)) {
+      self->contador[quadro] |= BIT_RECENTE;
+    }
+  }
+}
+
+static int subst__envelhecimento(subst_t *self)
+{
+  int escolhido = -1;
+  for (int quadro = 0; quadro < self->n_quadros; quadro++) {
+    if (!subst__substituivel(self, quadro)) continue;
+    if (escolhido == -1
+        || self->contador[quadro] < self->contador[escolhido]) {
+      escolhido = quadro;
+    }
+  }
+  return escolhido;
+}
+
+static void subst__tick_wsclock(subst_t *self, int pid)
+{
+  // as páginas acessadas pelo processo que estava executando têm o tempo
+  //   de uso atualizado para o tempo do processo
+  if (pid == 0) return;
+  int tempo = 0;
+  if (self->f_tempo != NULL) tempo = self->f_tempo(self->arg_tempo, pid);
+  subst__colhe(self, pid, true);
+  for (int quadro = 0; quadro < self->n_quadros; quadro++) {
+    if (subst__acessada(self, quadro)) {
+      self->t_uso[quadro] = tempo;
+    }
+  }
+}
+
+static int subst__wsclock(subst_t *self)
+{
+  // escolhe a primeira página fora do conjunto de trabalho e não alterada
+  // se não tiver, a primeira fora do conjunto de trabalho alterada (o SO
+  //   grava antes de liberar o quadro, não tem fila de gravação); se todas
+  //   estiverem no conjunto de trabalho, a com uso menos recente
+  // se todas tiverem sido acessadas, os bits são desligados na primeira
+  //   volta, e a escolha é feita na segunda
+  subst__colhe(self, 0, false);
+  for (int volta = 0; volta < 2; volta++) {
+    int alterada = -1;
+    int mais_antiga = -1;
+    int maior_idade = -1;
+    for (int n = 0; n < self->n_quadros; n++) {
+      int quadro = subst__avanca_ponteiro(self);
+      if (!subst__substituivel(self, quadro)) continue;
+      int tempo = subst__tempo_do_dono(self, quadro);
+      if (subst__acessada(self, quadro)) {
+        subst__zera_acesso(self, quadro);
+        self->t_uso[quadro] = tempo;
+        continue;
+      }
+      int idade = tempo - self->t_uso[quadro];
+      if (idade > self->tau) {
+        if (!subst__alterada(self, quadro)) return quadro;
+        if (alterada == -1) alterada = quadro;
+      }
+      if (idade > maior_idade) {
+        maior_idade = idade;
+        mais_antiga = quadro;
+      }
+    }
+    // o ponteiro deu a volta; passa a apontar para depois do escolhido,
+    //   para a próxima escolha não começar pelos mesmos quadros
+    int escolhido = alterada != -1 ? alterada : mais_antiga;
+    if (escolhido != -1) {
+      self->ponteiro = (escolhido + 1) % self->n_quadros;
+      return escolhido;
+    }
+  }
+  return -1;
+}
+
+static subst_ops_t algoritmos[N_SUBST] = {
+  [SUBST_FIFO]           = { "fifo", subst__tick_nada, subst__fifo },
+  [SUBST_SEGUNDA_CHANCE] = { "segunda_chance", subst__tick_nada,
+                             subst__segunda_chance },
+  [SUBST_RELOGIO]        = { "relogio", subst__tick_nada, subst__relogio },
+  [SUBST_ENVELHECIMENTO] = { "envelhecimento", subst__tick_envelhecimento,
+                             subst__envelhecimento },
+  [SUBST_WSCLOCK]        = { "wsclock", subst__tick_wsclock, subst__wsclock },
+};
+
+
+// interface
+
+subst_t *subst_cria(subst_alg_t alg, quadros_t *quadros, int tau,
+                    subst_f_tempo_t f_tempo, void *arg)
+{
+  if (alg < 0 || alg >= N_SUBST) return NULL;
+  subst_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->quadros = quadros;
+  self->n_quadros = quadros_num(quadros);
+  self->ops = &algoritmos[alg];
+  self->prox = malloc(self->n_quadros * sizeof(int));
+  self->ant = malloc(self->n_quadros * sizeof(int));
+  self->contador = malloc(self->n_quadros * sizeof(unsigned));
+  self->t_uso = malloc(self->n_quadros * sizeof(int));
+  self->colheita_do_quadro = malloc(self->n_quadros * sizeof(int));
+  self->colheitas = NULL;
+  self->n_colheitas = 0;
+  self->max_colheitas = 0;
+  if (self->prox == NULL || self->ant == NULL || self->contador == NULL
+      || self->t_uso == NULL || self->colheita_do_quadro == NULL) {
+    subst_destroi(self);
+    return NULL;
+  }
+  self->primeiro = -1;
+  self->ultimo = -1;
+  self->ponteiro = 0;
+  self->tau = tau;
+  self->f_tempo = f_tempo;
+  self->arg_tempo = arg;
+  return self;
+}
+
+void subst_destroi(subst_t *self)
+{
+  free(self->prox);
+  free(self->ant);
+  free(self->contador);
+  free(self->t_uso);
+  for (int i = 0; i < self->max_colheitas; i++) {
+    free(self->colheitas[i].acessadas);
+    free(self->colheitas[i].alteradas);
+  }
+  free(self->colheitas);
+  free(self->colheita_do_quadro);
+  free(self);
+}
+
+char *subst_nome(subst_alg_t alg)
+{
+  if (alg < 0 || alg >= N_SUBST) return "?";
+  return algoritmos[alg].nome;
+}
+
+int subst_alg_por_nome(char *nome)
+{
+  for (subst_alg_t alg = 0; alg < N_SUBST; alg++) {
+    if (strcmp(nome, algoritmos[alg].nome) == 0) return alg;
+  }
+  return -1;
+}
+
+void subst_notifica_carga(subst_t *self, int quadro)
+{
+  // a página recém carregada conta como acessada agora
+  subst__insere_na_fila(self, quadro);
+  self->contador[quadro] = BIT_RECENTE;
+  self->t_uso[quadro] = subst__tempo_do_dono(self, quadro);
+}
+
+void subst_notifica_liberacao(subst_t *self, int quadro)
+{
+  subst__remove_da_fila(self, quadro);
+}
+
+void subst_tick(subst_t *self, int pid)
+{
+  self->ops->tick(self, pid);
+}
+
+int subst_escolhe_vitima(subst_t *self)
+{
+  return self->ops->escolhe_vitima(self);
+}
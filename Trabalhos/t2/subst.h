@@ -0,0 +1,85 @@
+#ifndef SUBST_H
+#define SUBST_H
+
+// substituição de páginas
+// escolhe, quando não há quadro livre na memória principal, o quadro
+//   que vai ser liberado para receber a página que causou uma falta
+// o SO informa cada página colocada em um quadro (subst_notifica_carga)
+//   e cada quadro liberado (subst_notifica_liberacao), e chama
+//   subst_tick a cada interrupção do relógio; os acessos às páginas não
+//   passam pelo substituidor: a escolha usa os bits de acesso e alteração,
+//   que a MMU marca nas tabelas de páginas (a página de cada quadro é
+//   obtida da tabela de quadros)
+// o algoritmo é escolhido na criação:
+//   fifo - a página que está há mais tempo na memória
+//   segunda_chance - como fifo, mas uma página acessada (com o bit de
+//     acesso ligado) vai para o final da fila, com o bit desligado
+//   relogio - percorre os quadros circularmente, a partir de onde parou
+//     na escolha anterior, desligando o bit de acesso das páginas
+//     acessadas, até encontrar uma não acessada
+//   envelhecimento - (NFU com envelhecimento) cada quadro tem um contador,
+//     que a cada tick é deslocado à direita, recebendo o bit de acesso no
+//     bit mais significativo (e o bit de acesso é desligado); escolhe a
+//     página com o menor contador
+//   wsclock - como relogio, mas considerando o conjunto de trabalho de
+//     cada processo: a página não acessada nos últimos 'tau' ticks do
+//     tempo de execução do dono está fora do conjunto de trabalho e pode
+//     ser escolhida, de preferência se não tiver sido alterada
+//     (ver Assuntos/wsclock.md)
+
+#include "quadros.h"
+
+typedef struct subst_t subst_t;
+
+typedef enum {
+  SUBST_FIFO,
+  SUBST_SEGUNDA_CHANCE,
+  SUBST_RELOGIO,
+  SUBST_ENVELHECIMENTO,
+  SUBST_WSCLOCK,
+  N_SUBST
+} subst_alg_t;
+
+// tipo da função que informa o tempo de execução de um processo (o número
+//   de ticks em que ele estava executando), usada pelo wsclock
+// recebe o argumento fornecido na criação e o pid do processo
+typedef int (*subst_f_tempo_t)(void *arg, int pid);
+
+// cria o substituidor de páginas, com o algoritmo 'alg', para os quadros
+//   da tabela 'quadros'
+// 'tau' é o tamanho da janela do conjunto de trabalho, em ticks, e
+//   'f_tempo' (com o argumento 'arg') informa o tempo de execução dos
+//   processos; só são usados pelo wsclock
+// retorna NULL em caso de erro
+subst_t *subst_cria(subst_alg_t alg, quadros_t *quadros, int tau,
+                    subst_f_tempo_t f_tempo, void *arg);
+
+// destrói o substituidor
+void subst_destroi(subst_t *self);
+
+// retorna o nome do algoritmo 'alg'
+char *subst_nome(subst_alg_t alg);
+
+// retorna o algoritmo com o nome 'nome', ou -1 se não existir
+int subst_alg_por_nome(char *nome);
+
+// informa que uma página foi colocada no quadro 'quadro' (a tabela de
+//   quadros já deve ter o dono)
+void subst_notifica_carga(subst_t *self, int quadro);
+
+// informa que o quadro 'quadro' foi liberado (deve ser chamada antes de
+//   liberar o quadro na tabela de quadros)
+void subst_notifica_liberacao(subst_t *self, int quadro);
+
+// informa a passagem de um tick de relógio, enquanto o processo 'pid'
+//   estava executando (0 se nenhum)
+void subst_tick(subst_t *self, int pid);
+
+// escolhe um quadro ocupado para ser liberado, entre os que podem ser
+//   substituídos (não fixos e não em transferência, ver quadros.h)
+// retorna o número do quadro, ou -1 se não tiver quadro que possa ser
+//   escolhido
+// não libera o quadro, nem altera a tabela de quadros
+int subst_escolhe_vitima(subst_t *self);
+
+#endif // SUBST_H
@@ -1,67 +1,383 @@
 #include "tabpag.h"
 #include "err.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
+// descritor de uma página, em 32 bits:
+//   bits 0-23 - número do quadro, se a página estiver presente
+//   bit 24 - página presente na memória principal
+//   bit 25 - página na memória secundária (reservado)
+//   bits 26-28 - proteção: leitura, escrita, execução (reservados)
+// os bits de acesso e alteração ficam nos mapas de bits da tabela
+// o descritor de uma página não mapeada é 0
+typedef uint32_t descritor_t;
+#define DESCR_QUADRO       0x00ffffffu
+#define DESCR_PRESENTE     (1u << 24)
+#define DESCR_SECUNDARIA   (1u << 25)
+#define DESCR_PROT_LEITURA (1u << 26)
+#define DESCR_PROT_ESCRITA (1u << 27)
+#define DESCR_PROT_EXEC    (1u << 28)
+
+// número de palavras de 64 bits necessárias para 'n' bits
+#define PALAVRAS(n) (((n) + 63) / 64)
+
+// folha da tabela de dois níveis: os descritores e os bits de acesso e
+//   alteração de PAGINAS_POR_FOLHA páginas consecutivas (múltiplo de 64,
+//   para os bits de uma folha ocuparem palavras inteiras)
+#define PAGINAS_POR_FOLHA 256
+#define PALAVRAS_POR_FOLHA (PAGINAS_POR_FOLHA / 64)
 typedef struct {
-  int quadro;
-  bool acessada;
-  bool alterada;
-} descritor_t;
+  descritor_t descritores[PAGINAS_POR_FOLHA];
+  uint64_t acessadas[PALAVRAS_POR_FOLHA];
+  uint64_t alteradas[PALAVRAS_POR_FOLHA];
+  int n_mapeadas;     // páginas mapeadas na folha; sem nenhuma, é liberada
+} folha_t;
 
 struct tabpag_t {
-  descritor_t *tabela;
+  tabpag_tipo_t tipo;
+  // número de páginas da tabela (1 a mais que a maior página mapeada)
   int tam_tab;
+  // tabela linear: descritores e mapas de bits com espaço para cap_tab
+  //   páginas, que cresce em dobro para não realocar a cada página nova, e
+  //   não diminui abaixo de cap_min (o tamanho inicial pedido na criação)
+  // os bits de acesso e alteração ficam um bit por página (o bit
+  //   pagina%64 da palavra pagina/64), para poderem ser colhidos uma
+  //   palavra por vez; os bits das páginas não mapeadas são sempre 0
+  descritor_t *tabela;
+  int cap_tab;
+  int cap_min;
+  uint64_t *acessadas;
+  uint64_t *alteradas;
+  // tabela de dois níveis: diretorio[i] é a folha das páginas a partir de
+  //   i*PAGINAS_POR_FOLHA, ou NULL se nenhuma delas estiver mapeada; o
+  //   diretório tem tam_dir entradas, e cresce em dobro
+  folha_t **diretorio;
+  int tam_dir;
+  // tamanho da página; se for potência de 2, bits_pagina é o log2 do
+  //   tamanho e mascara_pagina seleciona o deslocamento; senão bits_pagina
+  //   é -1
+  int tam_pagina;
+  int bits_pagina;
+  int mascara_pagina;
+  // quem deve ser avisado quando uma entrada é alterada
+  tabpag_f_alteracao_t f_alteracao;
+  void *arg_alteracao;
 };
 
-tabpag_t *tabpag_cria(void)
+static char *nomes_tipo[N_TABPAG_TIPO] = {
+  [TABPAG_LINEAR]   = "linear",
+  [TABPAG_2_NIVEIS] = "2niveis",
+};
+
+static void tabpag__realoca(tabpag_t *self, int cap);
+static void tabpag__realoca_diretorio(tabpag_t *self, int tam_dir);
+
+tabpag_t *tabpag_cria(tabpag_tipo_t tipo, int tam_pagina, int n_paginas)
 {
+  if (tipo < 0 || tipo >= N_TABPAG_TIPO) return NULL;
+  if (tam_pagina < 1 || n_paginas < 0) return NULL;
   tabpag_t *self = malloc(sizeof(*self));
   if (self == NULL) return self;
-  self->tabela = NULL;
+  self->tipo = tipo;
   self->tam_tab = 0;
+  self->tabela = NULL;
+  self->cap_tab = 0;
+  self->cap_min = 0;
+  self->acessadas = NULL;
+  self->alteradas = NULL;
+  self->diretorio = NULL;
+  self->tam_dir = 0;
+  self->tam_pagina = tam_pagina;
+  self->bits_pagina = -1;
+  self->mascara_pagina = tam_pagina - 1;
+  if ((tam_pagina & (tam_pagina - 1)) == 0) {
+    self->bits_pagina = 0;
+    while ((1 << self->bits_pagina) < tam_pagina) {
+      self->bits_pagina++;
+    }
+  }
+  self->f_alteracao = NULL;
+  self->arg_alteracao = NULL;
+  if (tipo == TABPAG_LINEAR) {
+    self->cap_min = n_paginas;
+    tabpag__realoca(self, n_paginas);
+  } else {
+    tabpag__realoca_diretorio(self, (n_paginas + PAGINAS_POR_FOLHA - 1)
+                                    / PAGINAS_POR_FOLHA);
+  }
   return self;
 }
 
 void tabpag_destroi(tabpag_t *self)
 {
-  if (self->tabela != NULL) free(self->tabela);
+  free(self->tabela);
+  free(self->acessadas);
+  free(self->alteradas);
+  for (int i = 0; i < self->tam_dir; i++) {
+    free(self->diretorio[i]);
+  }
+  free(self->diretorio);
   free(self);
 }
 
-static void tabpag__remove_pagina(tabpag_t *self, int pagina)
+char *tabpag_tipo_nome(tabpag_tipo_t tipo)
 {
-  if (pagina >= self->tam_tab) return;
-  if (pagina < self->tam_tab - 1) {
-    self->tabela[pagina].quadro = -1;
-    return;
+  if (tipo < 0 || tipo >= N_TABPAG_TIPO) return "?";
+  return nomes_tipo[tipo];
+}
+
+int tabpag_tipo_por_nome(char *nome)
+{
+  for (tabpag_tipo_t tipo = 0; tipo < N_TABPAG_TIPO; tipo++) {
+    if (strcmp(nome, nomes_tipo[tipo]) == 0) return tipo;
   }
-  do {
-    self->tam_tab--;
-  } while (self->tam_tab > 0 && self->tabela[self->tam_tab - 1].quadro == -1);
-  if (self->tam_tab == 0) {
+  return -1;
+}
+
+// avisa quem estiver interessado que a entrada da página foi alterada
+static void tabpag__avisa_alteracao(tabpag_t *self, int pagina)
+{
+  if (self->f_alteracao != NULL) {
+    self->f_alteracao(self->arg_alteracao, pagina);
+  }
+}
+
+int tabpag_tam_pagina(tabpag_t *self)
+{
+  return self->tam_pagina;
+}
+
+
+// acesso aos descritores e bits de uma página, nos dois tipos de tabela
+
+// retorna a folha que contém a página, ou NULL se não tiver
+static folha_t *tabpag__folha(tabpag_t *self, int pagina)
+{
+  int i = pagina / PAGINAS_POR_FOLHA;
+  if (i >= self->tam_dir) return NULL;
+  return self->diretorio[i];
+}
+
+// retorna o descritor da página (0 se não mapeada)
+static descritor_t tabpag__le_descritor(tabpag_t *self, int pagina)
+{
+  if (pagina >= self->tam_tab) return 0;
+  if (self->tipo == TABPAG_LINEAR) return self->tabela[pagina];
+  folha_t *folha = tabpag__folha(self, pagina);
+  if (folha == NULL) return 0;
+  return folha->descritores[pagina % PAGINAS_POR_FOLHA];
+}
+
+// retorna as palavras dos mapas de bits de acesso e alteração que contêm
+//   o bit da página (o bit pagina%64), ou false se a página não tem espaço
+//   alocado
+static bool tabpag__palavras(tabpag_t *self, int pagina,
+                             uint64_t **pacesso, uint64_t **palteracao)
+{
+  if (pagina >= self->tam_tab) return false;
+  if (self->tipo == TABPAG_LINEAR) {
+    *pacesso = &self->acessadas[pagina / 64];
+    *palteracao = &self->alteradas[pagina / 64];
+    return true;
+  }
+  folha_t *folha = tabpag__folha(self, pagina);
+  if (folha == NULL) return false;
+  *pacesso = &folha->acessadas[pagina % PAGINAS_POR_FOLHA / 64];
+  *palteracao = &folha->alteradas[pagina % PAGINAS_POR_FOLHA / 64];
+  return true;
+}
+
+// retorna a palavra 'i' (páginas i*64 a i*64+63) de um dos mapas de bits
+//   (de alteração se 'alteracao', senão de acesso), ou NULL se não tiver
+//   espaço alocado para essas páginas
+static uint64_t *tabpag__palavra_do_mapa(tabpag_t *self, int i,
+                                         bool alteracao)
+{
+  if (self->tipo == TABPAG_LINEAR) {
+    return alteracao ? &self->alteradas[i] : &self->acessadas[i];
+  }
+  folha_t *folha = tabpag__folha(self, i * 64);
+  if (folha == NULL) return NULL;
+  if (alteracao) return &folha->alteradas[i % PALAVRAS_POR_FOLHA];
+  return &folha->acessadas[i % PALAVRAS_POR_FOLHA];
+}
+
+static uint64_t tabpag__mascara(int pagina)
+{
+  return (uint64_t)1 << (pagina % 64);
+}
+
+// retorna a posição do bit ligado menos significativo de 'bits' (que não
+//   pode ser 0), sem extensão do compilador: bits & -bits isola esse bit,
+//   e a multiplicação por uma sequência de De Bruijn coloca nos 6 bits
+//   mais altos um índice diferente para cada posição
+static int tabpag__bit_mais_baixo(uint64_t bits)
+{
+  static const int posicao[64] = {
+     0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6,
+  };
+  uint64_t isolado = bits & -bits;
+  return posicao[(isolado * UINT64_C(0x03f79d71b4cb0a89)) >> 58];
+}
+
+
+// tabela linear
+
+// altera o espaço da tabela (descritores e mapas de bits) para 'cap'
+//   páginas (que deve ser pelo menos tam_tab); o espaço novo é zerado
+static void tabpag__realoca(tabpag_t *self, int cap)
+{
+  if (cap == self->cap_tab) return;
+  if (cap == 0) {
     free(self->tabela);
+    free(self->acessadas);
+    free(self->alteradas);
     self->tabela = NULL;
-  } else {
-    self->tabela = realloc(self->tabela, self->tam_tab * sizeof(descritor_t));
-    assert(self->tabela != NULL);
+    self->acessadas = NULL;
+    self->alteradas = NULL;
+    self->cap_tab = 0;
+    return;
+  }
+  self->tabela = realloc(self->tabela, cap * sizeof(descritor_t));
+  assert(self->tabela != NULL);
+  if (cap > self->cap_tab) {
+    memset(self->tabela + self->cap_tab, 0,
+           (cap - self->cap_tab) * sizeof(descritor_t));
   }
+  int palavras_antes = PALAVRAS(self->cap_tab);
+  int palavras = PALAVRAS(cap);
+  if (palavras != palavras_antes) {
+    self->acessadas = realloc(self->acessadas, palavras * sizeof(uint64_t));
+    self->alteradas = realloc(self->alteradas, palavras * sizeof(uint64_t));
+    assert(self->acessadas != NULL && self->alteradas != NULL);
+    if (palavras > palavras_antes) {
+      int novas = palavras - palavras_antes;
+      memset(self->acessadas + palavras_antes, 0, novas * sizeof(uint64_t));
+      memset(self->alteradas + palavras_antes, 0, novas * sizeof(uint64_t));
+    }
+  }
+  self->cap_tab = cap;
 }
 
-static void tabpag__insere_pagina(tabpag_t *self, int pagina)
+// retorna o descritor da página, alocando espaço se necessário
+static descritor_t *tabpag__insere_linear(tabpag_t *self, int pagina)
 {
-  if (pagina < self->tam_tab) return;
-  int novo_tam = pagina + 1;
-  if (self->tam_tab == 0) {
-    self->tabela = malloc(novo_tam * sizeof(descritor_t));
-  } else {
-    self->tabela = realloc(self->tabela, novo_tam * sizeof(descritor_t));
+  if (pagina >= self->cap_tab) {
+    int cap = 2 * self->cap_tab;
+    if (cap <= pagina) cap = pagina + 1;
+    tabpag__realoca(self, cap);
   }
-  assert(self->tabela != NULL);
-  while (self->tam_tab < novo_tam) {
-    self->tabela[self->tam_tab].quadro = -1;
-    self->tam_tab++;
+  return &self->tabela[pagina];
+}
+
+// a página mapeada de maior número mudou para uma menor que 'pagina'
+static void tabpag__encolhe_linear(tabpag_t *self, int pagina)
+{
+  self->tam_tab = pagina;
+  while (self->tam_tab > 0 && self->tabela[self->tam_tab - 1] == 0) {
+    self->tam_tab--;
+  }
+  // só diminui o espaço quando sobra bastante, para não realocar de novo
+  //   logo em seguida, se a tabela voltar a crescer
+  if (self->tam_tab <= self->cap_tab / 4
+      && self->cap_tab / 2 >= self->cap_min) {
+    tabpag__realoca(self, self->cap_tab / 2);
+  }
+}
+
+
+// tabela de dois níveis
+
+// aumenta o diretório para 'tam_dir' entradas (as novas sem folha)
+static void tabpag__realoca_diretorio(tabpag_t *self, int tam_dir)
+{
+  if (tam_dir <= self->tam_dir) return;
+  self->diretorio = realloc(self->diretorio, tam_dir * sizeof(folha_t *));
+  assert(self->diretorio != NULL);
+  while (self->tam_dir < tam_dir) {
+    self->diretorio[self->tam_dir++] = NULL;
+  }
+}
+
+// retorna o descritor da página, criando a folha se necessário
+static descritor_t *tabpag__insere_2_niveis(tabpag_t *self, int pagina)
+{
+  int i = pagina / PAGINAS_POR_FOLHA;
+  if (i >= self->tam_dir) {
+    int tam_dir = 2 * self->tam_dir;
+    if (tam_dir <= i) tam_dir = i + 1;
+    tabpag__realoca_diretorio(self, tam_dir);
+  }
+  if (self->diretorio[i] == NULL) {
+    self->diretorio[i] = calloc(1, sizeof(folha_t));
+    assert(self->diretorio[i] != NULL);
+  }
+  return &self->diretorio[i]->descritores[pagina % PAGINAS_POR_FOLHA];
+}
+
+// a página mapeada de maior número mudou para uma menor que 'pagina'
+static void tabpag__encolhe_2_niveis(tabpag_t *self, int pagina)
+{
+  // procura a maior página mapeada, pulando as folhas inexistentes
+  while (pagina > 0) {
+    folha_t *folha = tabpag__folha(self, pagina - 1);
+    if (folha == NULL) {
+      pagina -= (pagina - 1) % PAGINAS_POR_FOLHA + 1;
+      continue;
+    }
+    if (folha->descritores[(pagina - 1) % PAGINAS_POR_FOLHA] != 0) break;
+    pagina--;
+  }
+  self->tam_tab = pagina;
+}
+
+
+// alteração da tabela
+
+static void tabpag__remove_pagina(tabpag_t *self, int pagina)
+{
+  uint64_t *acesso, *alteracao;
+  if (!tabpag__palavras(self, pagina, &acesso, &alteracao)) return;
+  *acesso &= ~tabpag__mascara(pagina);
+  *alteracao &= ~tabpag__mascara(pagina);
+  if (self->tipo == TABPAG_LINEAR) {
+    self->tabela[pagina] = 0;
+    if (pagina == self->tam_tab - 1) tabpag__encolhe_linear(self, pagina);
+    return;
   }
+  folha_t *folha = tabpag__folha(self, pagina);
+  descritor_t *descr = &folha->descritores[pagina % PAGINAS_POR_FOLHA];
+  if (*descr == 0) return;
+  *descr = 0;
+  folha->n_mapeadas--;
+  if (folha->n_mapeadas == 0) {
+    free(folha);
+    self->diretorio[pagina / PAGINAS_POR_FOLHA] = NULL;
+  }
+  if (pagina == self->tam_tab - 1) tabpag__encolhe_2_niveis(self, pagina);
+}
+
+static void tabpag__insere_pagina(tabpag_t *self, int pagina, int quadro)
+{
+  descritor_t *descr;
+  if (self->tipo == TABPAG_LINEAR) {
+    descr = tabpag__insere_linear(self, pagina);
+  } else {
+    descr = tabpag__insere_2_niveis(self, pagina);
+    if (*descr == 0) tabpag__folha(self, pagina)->n_mapeadas++;
+  }
+  *descr = DESCR_PRESENTE | quadro;
+  // os descritores entre o tamanho antigo e a página nova já são 0 (não
+  //   mapeados)
+  if (pagina >= self->tam_tab) self->tam_tab = pagina + 1;
+  uint64_t *acesso, *alteracao;
+  tabpag__palavras(self, pagina, &acesso, &alteracao);
+  *acesso &= ~tabpag__mascara(pagina);
+  *alteracao &= ~tabpag__mascara(pagina);
 }
 
 void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro)
@@ -69,53 +385,125 @@ void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro)
   if (quadro == -1) {
     tabpag__remove_pagina(self, pagina);
   } else {
-    tabpag__insere_pagina(self, pagina);
-    self->tabela[pagina].quadro = quadro;
-    self->tabela[pagina].acessada = false;
-    self->tabela[pagina].alterada = false;
+    assert(quadro >= 0 && quadro <= DESCR_QUADRO);
+    tabpag__insere_pagina(self, pagina, quadro);
   }
+  tabpag__avisa_alteracao(self, pagina);
 }
 
 void tabpag_marca_bit_acesso(tabpag_t *self, int pagina, bool alteracao)
 {
-  if (pagina < self->tam_tab) {
-    self->tabela[pagina].acessada = true;
-    if (alteracao) {
-      self->tabela[pagina].alterada = true;
-    }
+  if (!(tabpag__le_descritor(self, pagina) & DESCR_PRESENTE)) return;
+  uint64_t *pacesso, *palteracao;
+  tabpag__palavras(self, pagina, &pacesso, &palteracao);
+  *pacesso |= tabpag__mascara(pagina);
+  if (alteracao) {
+    *palteracao |= tabpag__mascara(pagina);
   }
 }
 
 void tabpag_zera_bit_acesso(tabpag_t *self, int pagina)
 {
-  if (pagina < self->tam_tab) {
-    self->tabela[pagina].acessada = false;
+  if (pagina >= self->tam_tab) return;
+  uint64_t *pacesso, *palteracao;
+  if (tabpag__palavras(self, pagina, &pacesso, &palteracao)) {
+    *pacesso &= ~tabpag__mascara(pagina);
   }
+  tabpag__avisa_alteracao(self, pagina);
 }
 
 bool tabpag_bit_acesso(tabpag_t *self, int pagina)
 {
-  if (pagina < self->tam_tab) {
-    return self->tabela[pagina].acessada;
+  uint64_t *pacesso, *palteracao;
+  if (tabpag__palavras(self, pagina, &pacesso, &palteracao)) {
+    return (*pacesso & tabpag__mascara(pagina)) != 0;
   }
   return false;
 }
 
 bool tabpag_bit_alteracao(tabpag_t *self, int pagina)
 {
-  if (pagina < self->tam_tab) {
-    return self->tabela[pagina].alterada;
+  uint64_t *pacesso, *palteracao;
+  if (tabpag__palavras(self, pagina, &pacesso, &palteracao)) {
+    return (*palteracao & tabpag__mascara(pagina)) != 0;
   }
   return false;
 }
 
+int tabpag_num_paginas(tabpag_t *self)
+{
+  return self->tam_tab;
+}
+
+int tabpag_colhe_bits(tabpag_t *self, uint64_t *bitmap_R, uint64_t *bitmap_M,
+                      bool zera)
+{
+  int palavras = PALAVRAS(self->tam_tab);
+  if (palavras == 0) return 0;
+  if (self->tipo == TABPAG_LINEAR) {
+    if (bitmap_R != NULL) {
+      memcpy(bitmap_R, self->acessadas, palavras * sizeof(uint64_t));
+    }
+    if (bitmap_M != NULL) {
+      memcpy(bitmap_M, self->alteradas, palavras * sizeof(uint64_t));
+    }
+  } else {
+    // as palavras das folhas inexistentes são 0
+    for (int i = 0; i < palavras; i++) {
+      uint64_t *acesso = tabpag__palavra_do_mapa(self, i, false);
+      uint64_t *alteracao = tabpag__palavra_do_mapa(self, i, true);
+      if (bitmap_R != NULL) bitmap_R[i] = acesso == NULL ? 0 : *acesso;
+      if (bitmap_M != NULL) bitmap_M[i] = alteracao == NULL ? 0 : *alteracao;
+    }
+  }
+  if (zera) {
+    for (int i = 0; i < palavras; i++) {
+      uint64_t *acesso = tabpag__palavra_do_mapa(self, i, false);
+      if (acesso == NULL) continue;
+      uint64_t bits = *acesso;
+      *acesso = 0;
+      // quem guarda cópia da tradução (a TLB da MMU) deve ser avisado, para
+      //   o próximo acesso marcar o bit de novo
+      while (bits != 0 && self->f_alteracao != NULL) {
+        int b = tabpag__bit_mais_baixo(bits);
+        bits &= bits - 1;
+        tabpag__avisa_alteracao(self, i * 64 + b);
+      }
+    }
+  }
+  return self->tam_tab;
+}
+
+void tabpag_define_obs_alteracao(tabpag_t *self,
+                                 tabpag_f_alteracao_t f, void *arg)
+{
+  self->f_alteracao = f;
+  self->arg_alteracao = arg;
+}
+
 err_t tabpag_traduz(tabpag_t *self, int endvirt, int *pendfis)
 {
-  int pagina = endvirt / TAM_PAGINA;
+  if (endvirt < 0) return ERR_END_INV;
+  if (self->bits_pagina >= 0) {
+    // caminho rápido, página de tamanho potência de 2
+    int pagina = endvirt >> self->bits_pagina;
+    if (pagina >= self->tam_tab) return ERR_END_INV;
+    // o acesso à tabela linear é feito aqui mesmo, sem chamar função
+    descritor_t descr = self->tipo == TABPAG_LINEAR ? self->tabela[pagina]
+                        : tabpag__le_descritor(self, pagina);
+    if (!(descr & DESCR_PRESENTE)) return ERR_PAG_AUSENTE;
+    int quadro = descr & DESCR_QUADRO;
+    int deslocamento = endvirt & self->mascara_pagina;
+    *pendfis = (quadro << self->bits_pagina) | deslocamento;
+    return ERR_OK;
+  }
+  int pagina = endvirt / self->tam_pagina;
   if (pagina >= self->tam_tab) return ERR_END_INV;
-  int quadro = self->tabela[pagina].quadro;
-  if (quadro == -1) return ERR_PAG_AUSENTE;
-  int deslocamento = endvirt % TAM_PAGINA;
-  *pendfis = quadro * TAM_PAGINA + deslocamento;
+  descritor_t descr = self->tipo == TABPAG_LINEAR ? self->tabela[pagina]
+                      : tabpag__le_descritor(self, pagina);
+  if (!(descr & DESCR_PRESENTE)) return ERR_PAG_AUSENTE;
+  int quadro = descr & DESCR_QUADRO;
+  int deslocamento = endvirt % self->tam_pagina;
+  *pendfis = quadro * self->tam_pagina + deslocamento;
   return ERR_OK;
 }
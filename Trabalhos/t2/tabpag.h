@@ -8,24 +8,52 @@
 
 #include "err.h"
 #include <stdbool.h>
-
-// tamanho de uma página, em palavras de memória
-#define TAM_PAGINA 10
+#include <stdint.h>
 
 // tipo opaco que representa a tabela de páginas
 typedef struct tabpag_t tabpag_t;
 
-// cria uma tabela de páginas
+// organização da tabela, escolhida na criação
+//   TABPAG_LINEAR - um vetor com um descritor para cada página, da página 0
+//     até a maior página mapeada; a tradução é mais rápida
+//   TABPAG_2_NIVEIS - um diretório com ponteiros para folhas de descritores
+//     de páginas consecutivas; só existem as folhas que têm alguma página
+//     mapeada, o que economiza memória em espaços de endereçamento grandes
+//     e esparsos (código, dados e pilha em regiões afastadas)
+// o comportamento das operações é o mesmo nas duas
+typedef enum {
+  TABPAG_LINEAR,
+  TABPAG_2_NIVEIS,
+  N_TABPAG_TIPO
+} tabpag_tipo_t;
+
+// cria uma tabela de páginas do tipo 'tipo', para páginas de 'tam_pagina'
+//   palavras de memória (o mesmo tamanho configurado na MMU)
+// se o tamanho for potência de 2, a tradução é feita com deslocamento de
+//   bits e máscara; outros tamanhos são aceitos, mas a tradução é mais lenta
+//   (com divisão e resto)
+// 'n_paginas' é o número de páginas previsto, para a tabela já ser criada
+//   com esse espaço (0 se não se sabe); a tabela cresce se for necessário
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa tabela
 // retorna NULL em caso de erro
-tabpag_t *tabpag_cria(void);
+tabpag_t *tabpag_cria(tabpag_tipo_t tipo, int tam_pagina, int n_paginas);
 
 // destrói uma tabela de páginas
 // nenhuma outra operação pode ser realizada na tabela após esta chamada
 void tabpag_destroi(tabpag_t *self);
 
+// retorna o nome do tipo de tabela 'tipo'
+char *tabpag_tipo_nome(tabpag_tipo_t tipo);
+
+// retorna o tipo de tabela com o nome 'nome', ou -1 se não existir
+int tabpag_tipo_por_nome(char *nome);
+
+// retorna o tamanho das páginas da tabela, em palavras
+int tabpag_tam_pagina(tabpag_t *self);
+
 // define a tradução da página 'pagina' deve resultar no quadro 'quadro'
+// o número do quadro é limitado a 24 bits
 // se 'quadro' for -1, indica que a tradução não é possível, resultando em
 //   ERR_PAG_AUSENTE
 // os bits de acesso e alteração para essa página são zerados
@@ -48,6 +76,33 @@ bool tabpag_bit_acesso(tabpag_t *self, int pagina);
 // retorna false se a página não estiver mapeada em algum quadro
 bool tabpag_bit_alteracao(tabpag_t *self, int pagina);
 
+// retorna o número de páginas da tabela (1 a mais que a maior página
+//   mapeada, 0 se nenhuma)
+int tabpag_num_paginas(tabpag_t *self);
+
+// colhe os bits de acesso e de alteração de todas as páginas da tabela
+// o bit da página p fica no bit p%64 da palavra p/64 de 'bitmap_R' (acesso)
+//   e de 'bitmap_M' (alteração), que devem ter espaço para pelo menos
+//   (tabpag_num_paginas()+63)/64 palavras; qualquer dos dois pode ser NULL
+// os bits das páginas não mapeadas são 0
+// se 'zera' for true, zera os bits de acesso de todas as páginas (como
+//   tabpag_zera_bit_acesso em cada página acessada)
+// retorna o número de páginas da tabela
+int tabpag_colhe_bits(tabpag_t *self, uint64_t *bitmap_R, uint64_t *bitmap_M,
+                      bool zera);
+
+// tipo da função chamada quando uma entrada da tabela é alterada
+// recebe o argumento fornecido no registro e o número da página alterada
+typedef void (*tabpag_f_alteracao_t)(void *arg, int pagina);
+
+// registra a função 'f' para ser chamada (com o argumento 'arg') quando a
+//   tradução de uma página for alterada (tabpag_define_quadro) ou seu bit
+//   de acesso for zerado (tabpag_zera_bit_acesso, tabpag_colhe_bits)
+// usado pela MMU para manter coerente sua cache de traduções (TLB)
+// só uma função pode estar registrada; se 'f' for NULL, desfaz o registro
+void tabpag_define_obs_alteracao(tabpag_t *self,
+                                 tabpag_f_alteracao_t f, void *arg);
+
 // traduz o endereço virtual 'endvirt'; coloca o endereço físico correspondente
 //   na posição apontada por 'pendfis'
 // retorna erro (e não altera '*pendfis') se a tradução não for possível:
@@ -0,0 +1,9 @@
+; programa de teste para a execução em lote (ver alvo teste no Makefile)
+; lê do terminal até acabar a entrada; sem arquivo de entrada, fica
+;   bloqueado na primeira leitura, e o SO tem que parar a execução
+
+SO_LE    define 1  ; ver so.h
+
+mais     cargi SO_LE
+         chamas
+         desv mais